@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "esp_adc/adc_oneshot.h"
 #include "esp_err.h"
 
@@ -30,12 +33,50 @@ typedef struct {
     int max_value_mv;           /*!< Maximum ORP value in mV */
 } orp_sensor_config_t;
 
+/** ORP probe fault codes, numbered like the ZCL Analog Input Reliability attribute */
+typedef enum {
+    ORP_SENSOR_FAULT_NONE = 0,          /*!< No fault detected */
+    ORP_SENSOR_FAULT_OVER_RANGE = 2,    /*!< Above max_value_mv or ADC saturated at the upper rail */
+    ORP_SENSOR_FAULT_UNDER_RANGE = 3,   /*!< Below min_value_mv or input pulled to ground */
+    ORP_SENSOR_FAULT_STUCK = 6,         /*!< Noiseless identical readings, input no longer driven by the probe */
+    ORP_SENSOR_FAULT_NOISY = 7,         /*!< Excessive sample variance, e.g. fouled or floating probe */
+    ORP_SENSOR_FAULT_STEP = 8,          /*!< Sudden jump away from the running mean */
+    ORP_SENSOR_FAULT_DRIFT = 10,        /*!< Long-term mean drifted away from the post-calibration baseline */
+} orp_sensor_fault_t;
+
+/** temperature_cdeg value when no temperature is available, same as the ZCL invalid MeasuredValue */
+#define ORP_SENSOR_TEMPERATURE_INVALID  (INT16_MIN)
+
+/** ORP sensor reading */
+typedef struct {
+    int orp_mv;                 /*!< ORP value in millivolts, clamped to the configured range */
+    uint8_t samples;            /*!< ADC samples taken for this reading */
+    uint8_t tx_collisions;      /*!< Samples that overlapped a radio transmission */
+    orp_sensor_fault_t fault;   /*!< Most severe probe fault currently detected */
+    int16_t temperature_cdeg;   /*!< SoC temperature in 0.01 degC read with this burst, or ORP_SENSOR_TEMPERATURE_INVALID */
+    int64_t timestamp_us;       /*!< esp_timer_get_time() at the middle of the acquisition burst */
+} orp_sensor_reading_t;
+
+/** Sample history entry, readings averaged over CONFIG_ORP_SENSOR_HISTORY_INTERVAL_S */
+typedef struct {
+    uint32_t timestamp_s;       /*!< esp_timer_get_time() in seconds, midway between the first and last averaged reading */
+    int16_t orp_mv;             /*!< Average ORP value in millivolts */
+    uint8_t fault;              /*!< Last probe fault (orp_sensor_fault_t) seen in the interval, or ORP_SENSOR_FAULT_NONE */
+    uint8_t readings;           /*!< Number of readings averaged */
+} orp_sensor_history_entry_t;
+
+/** Radio state reported by the application */
+typedef enum {
+    ORP_SENSOR_RADIO_IDLE,      /*!< Radio idle, e.g. the stack is about to sleep or a transmission completed */
+    ORP_SENSOR_RADIO_TX,        /*!< Radio about to transmit */
+} orp_sensor_radio_state_t;
+
 /** ORP sensor callback
  *
- * @param[in] orp_mv ORP value in millivolts from sensor
+ * @param[in] reading ORP reading from sensor
  *
  */
-typedef void (*esp_orp_sensor_callback_t)(int orp_mv);
+typedef void (*esp_orp_sensor_callback_t)(const orp_sensor_reading_t *reading);
 
 /**
  * @brief Default ORP sensor configuration
@@ -86,6 +127,47 @@ esp_err_t orp_sensor_get_calibration(int *offset_mv);
  */
 esp_err_t orp_sensor_get_reading(int *orp_mv);
 
+/**
+ * @brief Copy the history entries newer than a point in time, oldest entry first
+ *
+ * @param since_us              esp_timer_get_time() value, only entries stamped after it are returned
+ * @param buf                   buffer to receive the entries, NULL with len 0 to only count them
+ * @param len                   capacity of buf in entries
+ * @param count                 pointer to store the number of entries copied, or matching when only counting
+ *
+ * @return ESP_OK if history copied successfully, ESP_ERR_INVALID_ARG on bad arguments.
+ */
+esp_err_t orp_sensor_get_history(int64_t since_us, orp_sensor_history_entry_t *buf, size_t len, size_t *count);
+
+/**
+ * @brief Close the history interval in progress into an entry now instead of when the interval is over
+ *
+ * Lets the application split the history where its delivery state changes, e.g. when the network
+ * is lost or joined again.
+ *
+ * @return ESP_OK if the interval was closed or was empty, ESP_ERR_INVALID_STATE if the driver is not initialized.
+ */
+esp_err_t orp_sensor_history_flush(void);
+
+/**
+ * @brief Get the minimum free stack seen by the sensor update task
+ *
+ * @param free_bytes            pointer to store the high-water mark in bytes
+ *
+ * @return ESP_OK if the task is running, otherwise ESP_ERR_INVALID_STATE.
+ */
+esp_err_t orp_sensor_get_stack_high_water_mark(uint32_t *free_bytes);
+
+/**
+ * @brief Tell the driver what the 802.15.4 radio is doing
+ *
+ * Acquisition bursts are held until the radio is idle, and samples taken between
+ * ORP_SENSOR_RADIO_TX and the next ORP_SENSOR_RADIO_IDLE are tagged as collisions.
+ *
+ * @param state                 current radio state
+ */
+void orp_sensor_radio_state_notify(orp_sensor_radio_state_t state);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -13,6 +13,10 @@
  */
 
 #include "orp_sensor_driver.h"
+#include "orp_sensor_health.h"
+
+#include <math.h>
+#include <stdlib.h>
 
 #include "esp_err.h"
 #include "esp_check.h"
@@ -20,8 +24,14 @@
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+#include "driver/temperature_sensor.h"
+#endif
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "sdkconfig.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 
@@ -51,9 +61,58 @@ static uint16_t interval = 1;
 /* calibration offset in mV */
 static int calibration_offset_mv = 0;
 
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+/* Coefficient in mV per 0.01 degC, Q20 fixed point */
+#define ORP_SENSOR_TEMP_COEFF_Q20       ((int64_t)CONFIG_ORP_SENSOR_TEMP_COEFF_UV_PER_C * (1 << 20) / 100000)
+#define ORP_SENSOR_TEMP_REFERENCE_CDEG  (CONFIG_ORP_SENSOR_TEMP_REFERENCE_C * 100)
+
+static temperature_sensor_handle_t temp_sensor_handle = NULL;
+#endif
+
+/* SoC temperature of the last update cycle and the correction derived from it */
+static int16_t temperature_cdeg = ORP_SENSOR_TEMPERATURE_INVALID;
+static int temp_correction_mv = 0;
+
+/* sensor update task */
+static TaskHandle_t update_task_handle = NULL;
+#if CONFIG_ORP_SENSOR_STATIC_ALLOCATION
+static StaticTask_t update_task_tcb;
+static StackType_t update_task_stack[CONFIG_ORP_SENSOR_TASK_STACK_SIZE];
+#endif
+
+/* sample history ring buffer, protected by history_lock */
+#if CONFIG_ORP_SENSOR_STATIC_ALLOCATION
+static orp_sensor_history_entry_t history_storage[CONFIG_ORP_SENSOR_HISTORY_DEPTH];
+static orp_sensor_history_entry_t *history = history_storage;
+#else
+static orp_sensor_history_entry_t *history = NULL;
+#endif
+static size_t history_head = 0;
+static size_t history_count = 0;
+static portMUX_TYPE history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* readings of the history interval in progress, protected by history_lock */
+static int32_t interval_sum_mv = 0;
+static uint8_t interval_readings = 0;
+static uint8_t interval_fault = ORP_SENSOR_FAULT_NONE;
+static int64_t interval_first_us = 0;
+static int64_t interval_last_us = 0;
+
+/* radio transmitting, set and cleared through orp_sensor_radio_state_notify() */
+static volatile bool radio_tx_active = false;
+
+#if CONFIG_ORP_SENSOR_SIMULATED_ADC
+#define ORP_SENSOR_SIMULATED_MV         (650)   /* Simulated probe sits in a 650 mV standard */
+#define ORP_SENSOR_NOISE_WINDOW         (32)    /* Readings per logged noise figure */
+#endif
+
 static const char *TAG = "ESP_ORP_SENSOR_DRIVER";
 static const char *NVS_NAMESPACE = "orp_sensor";
 static const char *NVS_CALIBRATION_KEY = "cal_offset";
+static const char *NVS_BASELINE_KEY = "cal_base";
+
+/* set when the calibration changed, the sensor task then restarts the health detectors */
+static volatile bool health_reset_pending = false;
 
 /**
  * @brief Initialize ADC calibration
@@ -129,10 +188,42 @@ static esp_err_t orp_sensor_load_calibration(void)
         ESP_LOGI(TAG, "Loaded calibration offset: %d mV", calibration_offset_mv);
     }
 
+    int32_t baseline_mv;
+    if (nvs_get_i32(nvs_handle, NVS_BASELINE_KEY, &baseline_mv) == ESP_OK) {
+        orp_sensor_health_set_baseline(baseline_mv);
+        ESP_LOGI(TAG, "Loaded drift baseline: %ld mV", baseline_mv);
+    }
+
     nvs_close(nvs_handle);
     return ESP_OK;
 }
 
+/**
+ * @brief Save the settled drift baseline to NVS, or erase it when a new calibration invalidates it
+ */
+static esp_err_t orp_sensor_save_baseline(bool valid, int baseline_mv)
+{
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS handle for writing");
+        return err;
+    }
+
+    err = valid ? nvs_set_i32(nvs_handle, NVS_BASELINE_KEY, baseline_mv) : nvs_erase_key(nvs_handle, NVS_BASELINE_KEY);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        err = nvs_commit(nvs_handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save drift baseline to NVS");
+    } else if (valid) {
+        ESP_LOGI(TAG, "Drift baseline saved: %d mV", baseline_mv);
+    }
+
+    nvs_close(nvs_handle);
+    return err;
+}
+
 /**
  * @brief Save calibration offset to NVS
  */
@@ -163,42 +254,260 @@ static esp_err_t orp_sensor_save_calibration(void)
     return err;
 }
 
+#if CONFIG_ORP_SENSOR_SIMULATED_ADC
+/**
+ * @brief Simulated probe: about 3 mV RMS white noise, plus supply droop and RF pickup while transmitting
+ */
+static int orp_sensor_simulated_sample_mv(bool radio_tx)
+{
+    int noise_mv = 0;
+    for (int i = 0; i < 4; i++) {
+        noise_mv += (int)(esp_random() % 5) - 2;
+    }
+    if (radio_tx) {
+        noise_mv += -20 + (int)(esp_random() % 31) - 15;
+    }
+    return ORP_SENSOR_SIMULATED_MV + noise_mv;
+}
+#endif
+
+/**
+ * @brief Take one ADC sample and convert it to millivolts
+ */
+static esp_err_t orp_sensor_sample_mv(int *voltage, bool radio_tx)
+{
+#if CONFIG_ORP_SENSOR_SIMULATED_ADC
+    *voltage = orp_sensor_simulated_sample_mv(radio_tx);
+#else
+    int adc_raw;
+    ESP_RETURN_ON_ERROR(adc_oneshot_read(adc_handle, adc_channel, &adc_raw), TAG, "ADC read failed");
+
+    if (adc_cali_handle) {
+        ESP_RETURN_ON_ERROR(adc_cali_raw_to_voltage(adc_cali_handle, adc_raw, voltage), TAG, "ADC calibration failed");
+    } else {
+        // Fallback calculation without calibration
+        *voltage = (adc_raw * 3300) / 4095;
+    }
+#endif
+    return ESP_OK;
+}
+
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+/**
+ * @brief Read the SoC temperature and derive this cycle's ORP correction
+ */
+static void orp_sensor_temperature_update(void)
+{
+    float celsius;
+    if (temperature_sensor_get_celsius(temp_sensor_handle, &celsius) != ESP_OK) {
+        /* Keep the previous correction, a single failed read should not shift readings */
+        ESP_LOGW(TAG, "Temperature sensor read failed");
+        return;
+    }
+    temperature_cdeg = (int16_t)lroundf(celsius * 100);
+    int32_t delta_cdeg = temperature_cdeg - ORP_SENSOR_TEMP_REFERENCE_CDEG;
+    temp_correction_mv = -(int)((ORP_SENSOR_TEMP_COEFF_Q20 * delta_cdeg + (1 << 19)) >> 20);
+    ESP_LOGD(TAG, "SoC temperature %.2f degC, ORP correction %d mV", celsius, temp_correction_mv);
+}
+#endif
+
 /**
  * @brief Read ORP value from ADC
+ *
+ * @param reading       reading to fill in.
+ * @param track_health  update task only: feed the burst to the probe health detectors and refresh the
+ *                      temperature correction. Other callers reuse the last correction.
  */
-static esp_err_t orp_sensor_read_raw(int *orp_mv)
+static esp_err_t orp_sensor_read_raw(orp_sensor_reading_t *reading, bool track_health)
 {
-    int adc_raw[10];
+    esp_err_t ret = ESP_OK;
     int voltage_sum = 0;
-    
+    int clean_sum = 0;
+    int clean_count = 0;
+
+    int64_t burst_start_us = esp_timer_get_time();
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION || CONFIG_ORP_SENSOR_ENERGY_TRACE
+    bool temp_sensor_on = false;
+#endif
+
+    reading->samples = CONFIG_ORP_SENSOR_SAMPLE_COUNT;
+    reading->tx_collisions = 0;
+    reading->fault = ORP_SENSOR_FAULT_NONE;
+    if (track_health) {
+        orp_sensor_health_burst_start();
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+        /* Powered up for this burst only, it settles while the ADC samples */
+        temp_sensor_on = temperature_sensor_enable(temp_sensor_handle) == ESP_OK;
+#endif
+    }
+
     // Take multiple readings for averaging
-    for (int i = 0; i < 10; i++) {
-        ESP_RETURN_ON_ERROR(adc_oneshot_read(adc_handle, adc_channel, &adc_raw[i]), TAG, "ADC read failed");
-        
-        if (adc_cali_handle) {
-            int voltage;
-            ESP_RETURN_ON_ERROR(adc_cali_raw_to_voltage(adc_cali_handle, adc_raw[i], &voltage), TAG, "ADC calibration failed");
-            voltage_sum += voltage;
+    for (int i = 0; i < CONFIG_ORP_SENSOR_SAMPLE_COUNT; i++) {
+        int voltage;
+        /* A transmission starting mid-conversion disturbs the sample as well */
+        bool radio_tx = radio_tx_active;
+        ESP_GOTO_ON_ERROR(orp_sensor_sample_mv(&voltage, radio_tx), err, TAG, "ADC sample failed");
+        radio_tx |= radio_tx_active;
+
+        voltage_sum += voltage;
+        if (radio_tx) {
+            reading->tx_collisions++;
         } else {
-            // Fallback calculation without calibration
-            voltage_sum += (adc_raw[i] * 3300) / 4095;
+            clean_sum += voltage;
+            clean_count++;
+            if (track_health) {
+                orp_sensor_health_sample(voltage);
+            }
+        }
+
+        if (i + 1 < CONFIG_ORP_SENSOR_SAMPLE_COUNT) {
+            vTaskDelay(pdMS_TO_TICKS(10)); // Small delay between readings
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(10)); // Small delay between readings
     }
-    
+
+    reading->timestamp_us = burst_start_us + (esp_timer_get_time() - burst_start_us) / 2;
+
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+    if (track_health) {
+        orp_sensor_temperature_update();
+        if (temp_sensor_on) {
+            temperature_sensor_disable(temp_sensor_handle);
+        }
+    }
+#endif
+    reading->temperature_cdeg = temperature_cdeg;
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+    if (track_health) {
+        /* Last field: whether the temperature sensor was powered during the burst */
+        ESP_LOGI(TAG, "ORP_ENERGY %lld adc %lld %d %d", burst_start_us / 1000, esp_timer_get_time() - burst_start_us,
+                 CONFIG_ORP_SENSOR_SAMPLE_COUNT, temp_sensor_on);
+    }
+#endif
+
     // Average the readings and apply calibration offset
-    int avg_voltage = voltage_sum / 10;
-    *orp_mv = avg_voltage + calibration_offset_mv;
-    
+#if CONFIG_ORP_SENSOR_RADIO_QUIET_SAMPLING
+    /* Leave out samples tagged as TX collisions unless nothing else is left */
+    int avg_voltage = clean_count ? clean_sum / clean_count : voltage_sum / CONFIG_ORP_SENSOR_SAMPLE_COUNT;
+#else
+    int avg_voltage = voltage_sum / CONFIG_ORP_SENSOR_SAMPLE_COUNT;
+#endif
+    reading->orp_mv = avg_voltage + calibration_offset_mv + temp_correction_mv;
+
+    /* Health detectors see the reading before clamping hides a railed or disconnected probe */
+    if (track_health) {
+        int baseline_mv;
+        bool baseline_settled;
+        reading->fault = orp_sensor_health_update(reading->orp_mv, sensor_config.min_value_mv, sensor_config.max_value_mv,
+                                                  &baseline_mv, &baseline_settled);
+        if (baseline_settled) {
+            orp_sensor_save_baseline(true, baseline_mv);
+        }
+    }
+
     // Clamp to configured range
-    if (*orp_mv < sensor_config.min_value_mv) {
-        *orp_mv = sensor_config.min_value_mv;
-    } else if (*orp_mv > sensor_config.max_value_mv) {
-        *orp_mv = sensor_config.max_value_mv;
+    if (reading->orp_mv < sensor_config.min_value_mv) {
+        reading->orp_mv = sensor_config.min_value_mv;
+    } else if (reading->orp_mv > sensor_config.max_value_mv) {
+        reading->orp_mv = sensor_config.max_value_mv;
     }
-    
+
     return ESP_OK;
+
+err:
+    /* Leave nothing powered or half-collected for the next burst */
+    if (track_health) {
+        orp_sensor_health_burst_abort();
+    }
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+    if (temp_sensor_on) {
+        temperature_sensor_disable(temp_sensor_handle);
+    }
+#endif
+    return ret;
+}
+
+#if CONFIG_ORP_SENSOR_SIMULATED_ADC
+/**
+ * @brief Log the spread of simulated readings around the true value
+ */
+static void orp_sensor_noise_report(const orp_sensor_reading_t *reading)
+{
+    static int64_t error_sq_sum = 0;
+    static uint32_t collisions = 0;
+    static int count = 0;
+
+    int error_mv = reading->orp_mv - calibration_offset_mv - temp_correction_mv - ORP_SENSOR_SIMULATED_MV;
+    error_sq_sum += error_mv * error_mv;
+    collisions += reading->tx_collisions;
+    if (++count == ORP_SENSOR_NOISE_WINDOW) {
+        ESP_LOGI(TAG, "Simulated reading noise: %.2f mV RMS over %d readings, %d samples each, %lu samples tagged as TX collisions",
+                 sqrtf((float)error_sq_sum / count), count, CONFIG_ORP_SENSOR_SAMPLE_COUNT, collisions);
+        error_sq_sum = 0;
+        collisions = 0;
+        count = 0;
+    }
+}
+#endif
+
+#if CONFIG_ORP_SENSOR_RADIO_QUIET_SAMPLING
+/**
+ * @brief Wait until the radio reports idle, or give up after the configured time
+ */
+static void orp_sensor_wait_radio_quiet(void)
+{
+    /* Only an idle notification that arrives from now on opens a window */
+    ulTaskNotifyValueClear(NULL, UINT32_MAX);
+    if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_ORP_SENSOR_RADIO_QUIET_WAIT_MS))) {
+        ESP_LOGD(TAG, "No radio-idle window within %d ms, sampling anyway", CONFIG_ORP_SENSOR_RADIO_QUIET_WAIT_MS);
+    }
+}
+#endif
+
+/**
+ * @brief Close the history interval in progress into an entry, call with history_lock held
+ */
+static void orp_sensor_history_close_locked(void)
+{
+    if (interval_readings == 0) {
+        return;
+    }
+    history[history_head] = (orp_sensor_history_entry_t) {
+        .timestamp_s = (uint32_t)((interval_first_us + (interval_last_us - interval_first_us) / 2) / 1000000),
+        .orp_mv = (int16_t)(interval_sum_mv / interval_readings),
+        .fault = interval_fault,
+        .readings = interval_readings,
+    };
+    history_head = (history_head + 1) % CONFIG_ORP_SENSOR_HISTORY_DEPTH;
+    if (history_count < CONFIG_ORP_SENSOR_HISTORY_DEPTH) {
+        history_count++;
+    }
+    interval_readings = 0;
+}
+
+/**
+ * @brief Add a reading to the history interval, closing the interval into an entry once it is over
+ */
+static void orp_sensor_history_add(const orp_sensor_reading_t *reading)
+{
+    portENTER_CRITICAL(&history_lock);
+    if (interval_readings &&
+        (reading->timestamp_us - interval_first_us >= CONFIG_ORP_SENSOR_HISTORY_INTERVAL_S * 1000000LL ||
+         interval_readings == UINT8_MAX)) {
+        orp_sensor_history_close_locked();
+    }
+
+    if (interval_readings == 0) {
+        interval_sum_mv = 0;
+        interval_fault = ORP_SENSOR_FAULT_NONE;
+        interval_first_us = reading->timestamp_us;
+    }
+    interval_sum_mv += reading->orp_mv;
+    interval_readings++;
+    interval_last_us = reading->timestamp_us;
+    if (reading->fault != ORP_SENSOR_FAULT_NONE) {
+        interval_fault = reading->fault;
+    }
+    portEXIT_CRITICAL(&history_lock);
 }
 
 /**
@@ -208,15 +517,38 @@ static esp_err_t orp_sensor_read_raw(int *orp_mv)
  */
 static void orp_sensor_driver_value_update(void *arg)
 {
+#if CONFIG_ORP_SENSOR_STACK_REPORT
+    UBaseType_t min_free_stack = CONFIG_ORP_SENSOR_TASK_STACK_SIZE;
+#endif
     for (;;) {
-        int orp_value;
-        if (orp_sensor_read_raw(&orp_value) == ESP_OK) {
+        orp_sensor_reading_t reading;
+#if CONFIG_ORP_SENSOR_RADIO_QUIET_SAMPLING
+        orp_sensor_wait_radio_quiet();
+#endif
+        if (health_reset_pending) {
+            health_reset_pending = false;
+            orp_sensor_health_reset();
+            orp_sensor_save_baseline(false, 0);
+        }
+        if (orp_sensor_read_raw(&reading, true) == ESP_OK) {
+            orp_sensor_history_add(&reading);
+#if CONFIG_ORP_SENSOR_SIMULATED_ADC
+            orp_sensor_noise_report(&reading);
+#endif
             if (func_ptr) {
-                func_ptr(orp_value);
+                func_ptr(&reading);
             }
         } else {
             ESP_LOGE(TAG, "Failed to read ORP sensor");
         }
+#if CONFIG_ORP_SENSOR_STACK_REPORT
+        /* The callback runs on this stack, so measure after it returns */
+        UBaseType_t free_stack = uxTaskGetStackHighWaterMark(NULL);
+        if (free_stack < min_free_stack) {
+            min_free_stack = free_stack;
+            ESP_LOGI(TAG, "Stack high-water mark: %u of %d bytes free", (unsigned)free_stack, CONFIG_ORP_SENSOR_TASK_STACK_SIZE);
+        }
+#endif
         vTaskDelay(pdMS_TO_TICKS(interval * 1000));
     }
 }
@@ -253,10 +585,26 @@ static esp_err_t orp_sensor_driver_sensor_init(orp_sensor_config_t *config)
     // Load calibration offset from NVS
     ESP_RETURN_ON_ERROR(orp_sensor_load_calibration(), TAG, "Failed to load calibration");
 
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+    temperature_sensor_config_t temp_sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+    ESP_RETURN_ON_ERROR(temperature_sensor_install(&temp_sensor_config, &temp_sensor_handle), TAG, "Failed to install temperature sensor");
+    ESP_LOGI(TAG, "Temperature compensation: %d uV/degC around %d degC", CONFIG_ORP_SENSOR_TEMP_COEFF_UV_PER_C,
+             CONFIG_ORP_SENSOR_TEMP_REFERENCE_C);
+#endif
+
     ESP_LOGI(TAG, "ORP sensor initialized - Range: %d-%d mV, Calibration offset: %d mV", 
              config->min_value_mv, config->max_value_mv, calibration_offset_mv);
 
-    return (xTaskCreate(orp_sensor_driver_value_update, "orp_sensor_update", 4096, NULL, 10, NULL) == pdTRUE) ? ESP_OK : ESP_FAIL;
+#if CONFIG_ORP_SENSOR_STATIC_ALLOCATION
+    update_task_handle = xTaskCreateStatic(orp_sensor_driver_value_update, "orp_sensor_update", CONFIG_ORP_SENSOR_TASK_STACK_SIZE,
+                                           NULL, 10, update_task_stack, &update_task_tcb);
+    return update_task_handle ? ESP_OK : ESP_FAIL;
+#else
+    history = calloc(CONFIG_ORP_SENSOR_HISTORY_DEPTH, sizeof(*history));
+    ESP_RETURN_ON_FALSE(history, ESP_ERR_NO_MEM, TAG, "Failed to allocate sample history");
+    return (xTaskCreate(orp_sensor_driver_value_update, "orp_sensor_update", CONFIG_ORP_SENSOR_TASK_STACK_SIZE,
+                        NULL, 10, &update_task_handle) == pdTRUE) ? ESP_OK : ESP_FAIL;
+#endif
 }
 
 esp_err_t orp_sensor_driver_init(orp_sensor_config_t *config, uint16_t update_interval, esp_orp_sensor_callback_t cb)
@@ -278,6 +626,8 @@ esp_err_t orp_sensor_set_calibration(int offset_mv)
     }
     
     calibration_offset_mv = offset_mv;
+    /* The offset shifts every reading, restart step and drift tracking from here */
+    health_reset_pending = true;
     return orp_sensor_save_calibration();
 }
 
@@ -295,5 +645,67 @@ esp_err_t orp_sensor_get_reading(int *orp_mv)
     if (orp_mv == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return orp_sensor_read_raw(orp_mv);
+    orp_sensor_reading_t reading;
+    ESP_RETURN_ON_ERROR(orp_sensor_read_raw(&reading, false), TAG, "Failed to read ORP sensor");
+    *orp_mv = reading.orp_mv;
+    return ESP_OK;
+}
+
+esp_err_t orp_sensor_get_history(int64_t since_us, orp_sensor_history_entry_t *buf, size_t len, size_t *count)
+{
+    if ((buf == NULL && len) || count == NULL || history == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t n = 0;
+    portENTER_CRITICAL(&history_lock);
+    size_t oldest = (history_head + CONFIG_ORP_SENSOR_HISTORY_DEPTH - history_count) % CONFIG_ORP_SENSOR_HISTORY_DEPTH;
+    for (size_t i = 0; i < history_count && (buf == NULL || n < len); i++) {
+        const orp_sensor_history_entry_t *entry = &history[(oldest + i) % CONFIG_ORP_SENSOR_HISTORY_DEPTH];
+        if ((int64_t)entry->timestamp_s * 1000000 <= since_us) {
+            continue;
+        }
+        if (buf) {
+            buf[n] = *entry;
+        }
+        n++;
+    }
+    portEXIT_CRITICAL(&history_lock);
+
+    *count = n;
+    return ESP_OK;
+}
+
+esp_err_t orp_sensor_history_flush(void)
+{
+    if (history == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&history_lock);
+    orp_sensor_history_close_locked();
+    portEXIT_CRITICAL(&history_lock);
+    return ESP_OK;
+}
+
+esp_err_t orp_sensor_get_stack_high_water_mark(uint32_t *free_bytes)
+{
+    if (free_bytes == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (update_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *free_bytes = uxTaskGetStackHighWaterMark(update_task_handle);
+    return ESP_OK;
+}
+
+void orp_sensor_radio_state_notify(orp_sensor_radio_state_t state)
+{
+    radio_tx_active = (state == ORP_SENSOR_RADIO_TX);
+#if CONFIG_ORP_SENSOR_RADIO_QUIET_SAMPLING
+    if (state == ORP_SENSOR_RADIO_IDLE && update_task_handle) {
+        xTaskNotifyGive(update_task_handle);
+    }
+#endif
 }
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee ORP sensor driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "orp_sensor_health.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief:
+ * Probe health detectors running next to the averaging in orp_sensor_read_raw().
+ *
+ * @note:
+ * Every detector keeps a constant amount of state and does O(1) integer work per
+ * sample, so they can run on every burst without a history buffer. Running means
+ * are exponentially weighted and kept in Q8 fixed point.
+ *
+ */
+
+#define ORP_HEALTH_RAIL_LOW_MV          (20)    /* Sample at or below this sits on the ground rail */
+#define ORP_HEALTH_RAIL_HIGH_MV         (3100)  /* Sample at or above this is ADC full scale */
+#define ORP_HEALTH_STUCK_READINGS       (20)    /* Identical noiseless readings before the input counts as stuck */
+#define ORP_HEALTH_NOISE_LIMIT_MV       (25)    /* Burst standard deviation that counts as excessive */
+#define ORP_HEALTH_NOISE_SHIFT          (2)     /* Burst variance averaged over ~4 readings */
+#define ORP_HEALTH_STEP_LIMIT_MV        (150)   /* Jump away from the fast mean that counts as a discontinuity */
+#define ORP_HEALTH_FAST_SHIFT           (3)     /* Fast mean follows ~8 readings, 2 minutes at 15 s */
+#define ORP_HEALTH_SLOW_SHIFT           (8)     /* Slow mean follows ~256 readings, about an hour at 15 s */
+#define ORP_HEALTH_DRIFT_LIMIT_MV       (60)    /* Slow mean distance from the baseline that counts as drift */
+
+/* current burst */
+static int burst_count;
+static int32_t burst_sum;
+static int64_t burst_sq_sum;
+static int burst_min;
+static int burst_max;
+static int burst_low_rail;
+static int burst_high_rail;
+
+/* per-reading detector state */
+static bool means_valid = false;
+static int32_t fast_mean_q8;
+static int32_t slow_mean_q8;
+static int64_t noise_var_q8;
+static int last_orp_mv;
+static int stuck_count;
+static uint32_t settle_count;
+static orp_sensor_fault_t last_fault = ORP_SENSOR_FAULT_NONE;
+
+/* drift baseline, settles one slow-mean time constant after calibration */
+static bool baseline_valid = false;
+static int drift_baseline_mv;
+
+void orp_sensor_health_reset(void)
+{
+    means_valid = false;
+    last_fault = ORP_SENSOR_FAULT_NONE;
+    stuck_count = 0;
+    settle_count = 0;
+    baseline_valid = false;
+}
+
+void orp_sensor_health_set_baseline(int baseline_mv)
+{
+    drift_baseline_mv = baseline_mv;
+    baseline_valid = true;
+}
+
+void orp_sensor_health_burst_start(void)
+{
+    burst_count = 0;
+    burst_sum = 0;
+    burst_sq_sum = 0;
+    burst_min = INT32_MAX;
+    burst_max = INT32_MIN;
+    burst_low_rail = 0;
+    burst_high_rail = 0;
+}
+
+void orp_sensor_health_burst_abort(void)
+{
+    orp_sensor_health_burst_start();
+}
+
+void orp_sensor_health_sample(int sample_mv)
+{
+    burst_count++;
+    burst_sum += sample_mv;
+    burst_sq_sum += (int64_t)sample_mv * sample_mv;
+    if (sample_mv < burst_min) {
+        burst_min = sample_mv;
+    }
+    if (sample_mv > burst_max) {
+        burst_max = sample_mv;
+    }
+    if (sample_mv <= ORP_HEALTH_RAIL_LOW_MV) {
+        burst_low_rail++;
+    } else if (sample_mv >= ORP_HEALTH_RAIL_HIGH_MV) {
+        burst_high_rail++;
+    }
+}
+
+orp_sensor_fault_t orp_sensor_health_update(int orp_mv, int min_mv, int max_mv, int *new_baseline_mv, bool *baseline_settled)
+{
+    *baseline_settled = false;
+    if (burst_count == 0) {
+        /* Every sample of the burst was discarded, keep the last verdict */
+        return last_fault;
+    }
+
+    /* Burst variance in Q8: (n * sum(x^2) - sum(x)^2) / n^2 */
+    int64_t var_q8 = ((burst_count * burst_sq_sum - (int64_t)burst_sum * burst_sum) << 8) / ((int64_t)burst_count * burst_count);
+    int32_t orp_q8 = (int32_t)orp_mv << 8;
+
+    if (!means_valid) {
+        fast_mean_q8 = orp_q8;
+        slow_mean_q8 = orp_q8;
+        noise_var_q8 = var_q8;
+        last_orp_mv = orp_mv;
+        means_valid = true;
+    }
+
+    /* Step: compare against the fast mean before it absorbs this reading */
+    bool step = abs(orp_mv - (fast_mean_q8 >> 8)) > ORP_HEALTH_STEP_LIMIT_MV;
+
+    fast_mean_q8 += (orp_q8 - fast_mean_q8) >> ORP_HEALTH_FAST_SHIFT;
+    slow_mean_q8 += (orp_q8 - slow_mean_q8) >> ORP_HEALTH_SLOW_SHIFT;
+    noise_var_q8 += (var_q8 - noise_var_q8) >> ORP_HEALTH_NOISE_SHIFT;
+
+    /* Stuck: a live probe always leaves some LSB noise in a burst */
+    if (burst_min == burst_max && orp_mv == last_orp_mv) {
+        if (stuck_count < ORP_HEALTH_STUCK_READINGS) {
+            stuck_count++;
+        }
+    } else {
+        stuck_count = 0;
+    }
+    last_orp_mv = orp_mv;
+
+    /* Drift: the slow mean needs one time constant to settle before it becomes the baseline */
+    bool drift = false;
+    if (!baseline_valid) {
+        if (++settle_count >= (1U << ORP_HEALTH_SLOW_SHIFT)) {
+            drift_baseline_mv = slow_mean_q8 >> 8;
+            baseline_valid = true;
+            *new_baseline_mv = drift_baseline_mv;
+            *baseline_settled = true;
+        }
+    } else {
+        drift = abs((slow_mean_q8 >> 8) - drift_baseline_mv) > ORP_HEALTH_DRIFT_LIMIT_MV;
+    }
+
+    /* Most severe first */
+    if (burst_high_rail * 2 > burst_count || orp_mv > max_mv) {
+        last_fault = ORP_SENSOR_FAULT_OVER_RANGE;
+    } else if (burst_low_rail * 2 > burst_count || orp_mv < min_mv) {
+        last_fault = ORP_SENSOR_FAULT_UNDER_RANGE;
+    } else if (stuck_count >= ORP_HEALTH_STUCK_READINGS) {
+        last_fault = ORP_SENSOR_FAULT_STUCK;
+    } else if (noise_var_q8 > ((int64_t)ORP_HEALTH_NOISE_LIMIT_MV * ORP_HEALTH_NOISE_LIMIT_MV << 8)) {
+        last_fault = ORP_SENSOR_FAULT_NOISY;
+    } else if (step) {
+        last_fault = ORP_SENSOR_FAULT_STEP;
+    } else if (drift) {
+        last_fault = ORP_SENSOR_FAULT_DRIFT;
+    } else {
+        last_fault = ORP_SENSOR_FAULT_NONE;
+    }
+    return last_fault;
+}
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee ORP sensor driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "orp_sensor_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Forget all detector state, e.g. after the calibration offset changed
+ */
+void orp_sensor_health_reset(void);
+
+/**
+ * @brief Restore the drift baseline stored with the calibration
+ *
+ * @param baseline_mv           long-term mean in millivolts settled after the last calibration
+ */
+void orp_sensor_health_set_baseline(int baseline_mv);
+
+/**
+ * @brief Start a new acquisition burst
+ */
+void orp_sensor_health_burst_start(void);
+
+/**
+ * @brief Drop the samples of a burst that failed, without running the detectors
+ */
+void orp_sensor_health_burst_abort(void);
+
+/**
+ * @brief Feed one ADC sample of the current burst
+ *
+ * @param sample_mv             sample in millivolts, before calibration offset
+ */
+void orp_sensor_health_sample(int sample_mv);
+
+/**
+ * @brief Close the burst and run the per-reading detectors
+ *
+ * @param orp_mv                calibrated reading in millivolts, before clamping
+ * @param min_mv                lower end of the configured range
+ * @param max_mv                upper end of the configured range
+ * @param[out] new_baseline_mv  set to the new drift baseline when one has just settled
+ * @param[out] baseline_settled true when new_baseline_mv is valid and should be persisted
+ *
+ * @return most severe fault currently detected
+ */
+orp_sensor_fault_t orp_sensor_health_update(int orp_mv, int min_mv, int max_mv, int *new_baseline_mv, bool *baseline_settled);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
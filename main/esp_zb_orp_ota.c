@@ -0,0 +1,270 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "esp_zb_orp_ota.h"
+#include "esp_zb_orp_poll.h"
+
+#include "esp_check.h"
+#include "esp_delta_ota.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <sys/param.h>
+
+/**
+ * @brief:
+ * Zigbee OTA Upgrade client writing into the inactive ota_0/ota_1 partition.
+ *
+ * @note:
+ * The OTA file carries either a full image (tag 0x0000) or a delta patch against
+ * the running firmware (tag 0xF000), built with tools/orp_ota_image.py. The patch
+ * is applied while blocks arrive: esp_delta_ota reads the base from the running
+ * partition and streams the merged image into the update partition, so RAM use
+ * is bounded by the decompressor window whatever the image size.
+ *
+ */
+
+#define ESP_ORP_OTA_FAST_POLL_MS    (5000)  /* Keep polling fast this long after every received block */
+
+static const char *TAG = "ESP_ZB_ORP_OTA";
+
+static const esp_partition_t *running_partition = NULL;
+static const esp_partition_t *update_partition = NULL;
+static esp_ota_handle_t ota_handle = 0;
+static esp_delta_ota_handle_t delta_handle = NULL;
+
+/* OTA file sub-element parser */
+static uint8_t element_header[6];
+static size_t element_header_len = 0;
+static uint16_t element_tag = 0;
+static uint32_t element_remaining = 0;
+static uint8_t base_digest[ESP_ORP_OTA_BASE_DIGEST_LEN];
+static size_t base_digest_len = 0;
+
+/* transfer statistics */
+static uint32_t blocks_received = 0;
+static uint32_t bytes_received = 0;
+static uint32_t bytes_written = 0;
+static int64_t start_time_us = 0;
+
+static esp_err_t esp_zb_orp_ota_base_read(uint8_t *buf_p, size_t size, int src_offset)
+{
+    return esp_partition_read(running_partition, src_offset, buf_p, size);
+}
+
+static esp_err_t esp_zb_orp_ota_merged_write(const uint8_t *buf_p, size_t size, void *user_data)
+{
+    bytes_written += size;
+    return esp_ota_write(ota_handle, buf_p, size);
+}
+
+static void esp_zb_orp_ota_cleanup(void)
+{
+    if (delta_handle) {
+        esp_delta_ota_deinit(delta_handle);
+        delta_handle = NULL;
+    }
+    if (ota_handle) {
+        esp_ota_abort(ota_handle);
+        ota_handle = 0;
+    }
+    esp_zb_orp_fast_poll_release(ESP_ORP_FAST_POLL_OTA);
+}
+
+static esp_err_t esp_zb_orp_ota_delta_start(void)
+{
+    uint8_t running_digest[ESP_ORP_OTA_BASE_DIGEST_LEN];
+    ESP_RETURN_ON_ERROR(esp_partition_get_sha256(running_partition, running_digest), TAG, "Failed to hash running firmware");
+    ESP_RETURN_ON_FALSE(memcmp(running_digest, base_digest, sizeof(base_digest)) == 0, ESP_ERR_INVALID_VERSION, TAG,
+                        "Delta patch was built against different firmware");
+
+    esp_delta_ota_cfg_t cfg = {
+        .read_cb = &esp_zb_orp_ota_base_read,
+        .write_cb_with_user_data = &esp_zb_orp_ota_merged_write,
+        .user_data = NULL,
+    };
+    delta_handle = esp_delta_ota_init(&cfg);
+    ESP_RETURN_ON_FALSE(delta_handle, ESP_ERR_NO_MEM, TAG, "Failed to initialise delta OTA");
+    ESP_LOGI(TAG, "Applying delta patch against the running firmware");
+    return ESP_OK;
+}
+
+static esp_err_t esp_zb_orp_ota_element_data(const uint8_t *data, size_t len)
+{
+    switch (element_tag) {
+    case ESP_ORP_OTA_TAG_UPGRADE_IMAGE:
+        bytes_written += len;
+        return esp_ota_write(ota_handle, data, len);
+    case ESP_ORP_OTA_TAG_DELTA_PATCH:
+        if (base_digest_len < sizeof(base_digest)) {
+            size_t take = MIN(len, sizeof(base_digest) - base_digest_len);
+            memcpy(base_digest + base_digest_len, data, take);
+            base_digest_len += take;
+            data += take;
+            len -= take;
+            if (base_digest_len == sizeof(base_digest)) {
+                ESP_RETURN_ON_ERROR(esp_zb_orp_ota_delta_start(), TAG, "Delta patch rejected");
+            }
+        }
+        return len ? esp_delta_ota_feed_patch(delta_handle, data, len) : ESP_OK;
+    default:
+        /* Unknown sub-elements are skipped as the OTA file format requires */
+        return ESP_OK;
+    }
+}
+
+static esp_err_t esp_zb_orp_ota_payload(const uint8_t *payload, size_t len)
+{
+    while (len) {
+        if (element_remaining == 0) {
+            /* Sub-element header: 16-bit tag, 32-bit length, little endian */
+            size_t take = MIN(len, sizeof(element_header) - element_header_len);
+            memcpy(element_header + element_header_len, payload, take);
+            element_header_len += take;
+            payload += take;
+            len -= take;
+            if (element_header_len == sizeof(element_header)) {
+                element_tag = element_header[0] | (element_header[1] << 8);
+                element_remaining = element_header[2] | (element_header[3] << 8) | (element_header[4] << 16) |
+                                    ((uint32_t)element_header[5] << 24);
+                element_header_len = 0;
+                ESP_LOGI(TAG, "OTA sub-element tag 0x%04x, %lu bytes", element_tag, element_remaining);
+            }
+            continue;
+        }
+        size_t take = MIN(len, element_remaining);
+        ESP_RETURN_ON_ERROR(esp_zb_orp_ota_element_data(payload, take), TAG, "Failed to write OTA data");
+        element_remaining -= take;
+        payload += take;
+        len -= take;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_orp_ota_upgrade_handler(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "OTA upgrade message with status %d", message->info.status);
+        return ESP_OK;
+    }
+
+    switch (message->upgrade_status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        ESP_LOGI(TAG, "OTA upgrade start, file version 0x%lx, %lu bytes", message->ota_header.file_version,
+                 message->ota_header.image_size);
+        esp_zb_orp_ota_cleanup();
+        running_partition = esp_ota_get_running_partition();
+        update_partition = esp_ota_get_next_update_partition(NULL);
+        ESP_RETURN_ON_FALSE(update_partition, ESP_ERR_NOT_FOUND, TAG, "No OTA partition to update");
+        ESP_RETURN_ON_ERROR(esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle), TAG,
+                            "Failed to begin OTA partition");
+        element_header_len = 0;
+        element_remaining = 0;
+        base_digest_len = 0;
+        blocks_received = 0;
+        bytes_received = 0;
+        bytes_written = 0;
+        start_time_us = esp_timer_get_time();
+        esp_zb_orp_fast_poll_request(ESP_ORP_FAST_POLL_OTA, ESP_ORP_OTA_FAST_POLL_MS);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        blocks_received++;
+        bytes_received += message->payload_size;
+        /* Image Block Responses wait at the parent until polled */
+        esp_zb_orp_fast_poll_request(ESP_ORP_FAST_POLL_OTA, ESP_ORP_OTA_FAST_POLL_MS);
+        if (message->payload_size && message->payload) {
+            ret = esp_zb_orp_ota_payload(message->payload, message->payload_size);
+            if (ret != ESP_OK) {
+                esp_zb_orp_ota_cleanup();
+                return ret;
+            }
+        }
+        ESP_LOGD(TAG, "OTA progress [%lu/%lu]", bytes_received, message->ota_header.image_size);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        if (element_remaining || element_header_len) {
+            ESP_LOGE(TAG, "OTA image truncated");
+            ret = ESP_ERR_INVALID_SIZE;
+        } else if (delta_handle) {
+            ret = esp_delta_ota_finalize(delta_handle);
+            esp_delta_ota_deinit(delta_handle);
+            delta_handle = NULL;
+        }
+        if (ret == ESP_OK) {
+            uint32_t full_blocks = (bytes_written + ESP_ORP_OTA_MAX_DATA_SIZE - 1) / ESP_ORP_OTA_MAX_DATA_SIZE;
+            ESP_LOGI(TAG, "OTA received %lu bytes in %lu blocks for a %lu byte image (full image: %lu blocks) in %lld s",
+                     bytes_received, blocks_received, bytes_written, full_blocks,
+                     (esp_timer_get_time() - start_time_us) / 1000000);
+        } else {
+            esp_zb_orp_ota_cleanup();
+        }
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        ESP_LOGI(TAG, "OTA upgrade apply");
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        ESP_LOGI(TAG, "OTA upgrade finished, rebooting into %s", update_partition->label);
+        ret = esp_ota_end(ota_handle);
+        ota_handle = 0;
+        ESP_RETURN_ON_ERROR(ret, TAG, "Failed to validate OTA image");
+        ESP_RETURN_ON_ERROR(esp_ota_set_boot_partition(update_partition), TAG, "Failed to set boot partition");
+        esp_restart();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        ESP_LOGW(TAG, "OTA upgrade aborted");
+        esp_zb_orp_ota_cleanup();
+        break;
+    default:
+        ESP_LOGI(TAG, "OTA upgrade status %d", message->upgrade_status);
+        break;
+    }
+    return ret;
+}
+
+void esp_zb_orp_ota_cluster_add(esp_zb_cluster_list_t *cluster_list)
+{
+    esp_zb_ota_cluster_cfg_t ota_cluster_cfg = {
+        .ota_upgrade_file_version = ESP_ORP_OTA_FILE_VERSION,
+        .ota_upgrade_downloaded_file_ver = ESP_ORP_OTA_FILE_VERSION,
+        .ota_upgrade_manufacturer = ESP_ORP_OTA_MANUFACTURER,
+        .ota_upgrade_image_type = ESP_ORP_OTA_IMAGE_TYPE,
+    };
+    esp_zb_attribute_list_t *ota_cluster = esp_zb_ota_cluster_create(&ota_cluster_cfg);
+
+    esp_zb_zcl_ota_upgrade_client_variable_t variable_config = {
+        .timer_query = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF,
+        .hw_version = ESP_ORP_OTA_HW_VERSION,
+        .max_data_size = ESP_ORP_OTA_MAX_DATA_SIZE,
+    };
+    uint16_t ota_upgrade_server_addr = 0xffff;
+    uint8_t ota_upgrade_server_ep = 0xff;
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &variable_config));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &ota_upgrade_server_addr));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &ota_upgrade_server_ep));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_ota_cluster(cluster_list, ota_cluster, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE));
+}
+
+void esp_zb_orp_ota_mark_valid(void)
+{
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_ERROR_CHECK(esp_ota_mark_app_valid_cancel_rollback());
+        ESP_LOGI(TAG, "New firmware joined the network, rollback cancelled");
+    }
+}
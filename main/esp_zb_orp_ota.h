@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+/* OTA Upgrade cluster configuration, must match the image built by tools/orp_ota_image.py */
+#define ESP_ORP_OTA_FILE_VERSION            (0x01000000)    /* Running firmware version, bump for every release */
+#define ESP_ORP_OTA_MANUFACTURER            (0x1001)
+#define ESP_ORP_OTA_IMAGE_TYPE              (0x1011)
+#define ESP_ORP_OTA_HW_VERSION              (0x0101)
+#define ESP_ORP_OTA_MAX_DATA_SIZE           (223)           /* Largest Image Block payload requested from the server */
+
+/* OTA file sub-element tags */
+#define ESP_ORP_OTA_TAG_UPGRADE_IMAGE       (0x0000)        /* Full application image */
+#define ESP_ORP_OTA_TAG_DELTA_PATCH         (0xF000)        /* SHA-256 of the base image followed by a detools heatshrink patch */
+#define ESP_ORP_OTA_BASE_DIGEST_LEN         (32)
+
+/**
+ * @brief Add the OTA Upgrade client cluster to the sensor endpoint
+ *
+ * @param cluster_list          cluster list of the sensor endpoint
+ */
+void esp_zb_orp_ota_cluster_add(esp_zb_cluster_list_t *cluster_list);
+
+/**
+ * @brief Handle OTA upgrade progress, call from the Zigbee action handler
+ *
+ * @param message               OTA upgrade value message
+ *
+ * @return ESP_OK to continue the upgrade, otherwise the upgrade is aborted.
+ */
+esp_err_t esp_zb_orp_ota_upgrade_handler(const esp_zb_zcl_ota_upgrade_value_message_t *message);
+
+/**
+ * @brief Confirm the running image after it joined a network, cancelling rollback
+ */
+void esp_zb_orp_ota_mark_valid(void);
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "esp_zb_orp_poll.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+
+/**
+ * @brief:
+ * Single owner of the stack's turbo poll state.
+ *
+ * @note:
+ * Poll Control and the OTA client both need the device to poll its parent
+ * quickly, on independent schedules. Each keeps a deadline here; turbo polling
+ * runs until the latest one and one scheduler alarm re-evaluates them, so
+ * neither can leave turbo polling while the other still depends on it.
+ *
+ */
+
+static const char *TAG = "ESP_ZB_ORP_POLL";
+
+static int64_t deadline_us[ESP_ORP_FAST_POLL_OWNER_MAX];   /* 0 when the owner needs no fast polling */
+static int64_t window_end_us = 0;                           /* end of the turbo poll window currently running */
+static bool active = false;
+
+static void esp_zb_orp_fast_poll_update(uint8_t param)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t latest_us = 0;
+    for (int i = 0; i < ESP_ORP_FAST_POLL_OWNER_MAX; i++) {
+        if (deadline_us[i] <= now_us) {
+            deadline_us[i] = 0;
+        } else if (deadline_us[i] > latest_us) {
+            latest_us = deadline_us[i];
+        }
+    }
+
+    esp_zb_scheduler_alarm_cancel(esp_zb_orp_fast_poll_update, 0);
+    if (!latest_us) {
+        if (active) {
+            esp_zb_zdo_pim_turbo_poll_continuous_leave();
+            active = false;
+            ESP_LOGI(TAG, "Fast poll window closed");
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+            ESP_LOGI(TAG, "ORP_ENERGY %lld fastpoll 0", now_us / 1000);
+#endif
+        }
+        return;
+    }
+
+    uint32_t remaining_ms = (uint32_t)((latest_us - now_us + 999) / 1000);
+    if (!active || latest_us != window_end_us) {
+        esp_zb_zdo_pim_start_turbo_poll_continuous(remaining_ms);
+        if (active) {
+            ESP_LOGD(TAG, "Fast poll window extended to %lu ms", remaining_ms);
+        } else {
+            ESP_LOGI(TAG, "Fast poll window opened for %lu ms", remaining_ms);
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+            ESP_LOGI(TAG, "ORP_ENERGY %lld fastpoll 1", now_us / 1000);
+#endif
+        }
+        active = true;
+        window_end_us = latest_us;
+    }
+    esp_zb_scheduler_alarm(esp_zb_orp_fast_poll_update, 0, remaining_ms);
+}
+
+void esp_zb_orp_fast_poll_request(esp_zb_orp_fast_poll_owner_t owner, uint32_t timeout_ms)
+{
+    deadline_us[owner] = esp_timer_get_time() + timeout_ms * 1000LL;
+    esp_zb_orp_fast_poll_update(0);
+}
+
+void esp_zb_orp_fast_poll_extend(esp_zb_orp_fast_poll_owner_t owner, uint32_t timeout_ms)
+{
+    int64_t until_us = esp_timer_get_time() + timeout_ms * 1000LL;
+    if (until_us > deadline_us[owner]) {
+        deadline_us[owner] = until_us;
+        esp_zb_orp_fast_poll_update(0);
+    }
+}
+
+void esp_zb_orp_fast_poll_release(esp_zb_orp_fast_poll_owner_t owner)
+{
+    deadline_us[owner] = 0;
+    esp_zb_orp_fast_poll_update(0);
+}
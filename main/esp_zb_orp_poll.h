@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Users of the fast-poll window, each holds its own deadline */
+typedef enum {
+    ESP_ORP_FAST_POLL_POLL_CONTROL = 0,     /* Poll Control check-ins, client requests, configuration writes */
+    ESP_ORP_FAST_POLL_OTA,                  /* OTA image block transfer */
+    ESP_ORP_FAST_POLL_OWNER_MAX,
+} esp_zb_orp_fast_poll_owner_t;
+
+/**
+ * @brief Fast poll for timeout_ms from now on behalf of owner, replacing its previous deadline
+ *
+ * @note Call from the Zigbee task or with the Zigbee lock held. The device fast polls until the
+ *       latest deadline of all owners, so an owner can never cut another owner's window short.
+ *
+ * @param owner                 user of the window
+ * @param timeout_ms            how long this owner needs fast polling
+ */
+void esp_zb_orp_fast_poll_request(esp_zb_orp_fast_poll_owner_t owner, uint32_t timeout_ms);
+
+/**
+ * @brief Fast poll for at least timeout_ms from now on behalf of owner, keeping a later deadline
+ *
+ * @param owner                 user of the window
+ * @param timeout_ms            minimum time this owner needs fast polling
+ */
+void esp_zb_orp_fast_poll_extend(esp_zb_orp_fast_poll_owner_t owner, uint32_t timeout_ms);
+
+/**
+ * @brief Drop the deadline of owner, fast polling ends once no other owner needs it
+ *
+ * @param owner                 user of the window
+ */
+void esp_zb_orp_fast_poll_release(esp_zb_orp_fast_poll_owner_t owner);
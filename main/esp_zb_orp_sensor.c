@@ -11,17 +11,24 @@
  * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
  * CONDITIONS OF ANY KIND, either express or implied.
  */
+#include "esp_zb_orp_ota.h"
+#include "esp_zb_orp_poll.h"
 #include "esp_zb_orp_sensor.h"
+#include "esp_zb_orp_time.h"
 #include "orp_sensor_driver.h"
 #include "switch_driver.h"
 
 #include "esp_check.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "ha/esp_zigbee_ha_standard.h"
 #include <stdlib.h>  /* For abs() function */
+#include <sys/param.h>  /* For MIN() */
 #ifdef CONFIG_PM_ENABLE
 #include "esp_pm.h"
 #include "esp_private/esp_clk.h"
@@ -35,11 +42,51 @@
 #endif
 
 static const char *TAG = "ESP_ZB_ORP_SENSOR";
+static const char *NVS_NAMESPACE = "orp_app";
+static const char *NVS_LAST_CHANNEL_KEY = "last_chan";
 
 static switch_func_pair_t button_func_pair[] = {
     {GPIO_INPUT_IO_TOGGLE_SWITCH, SWITCH_ONOFF_TOGGLE_CONTROL}
 };
 
+static TaskHandle_t zb_task_handle = NULL;
+#if CONFIG_ORP_SENSOR_STATIC_ALLOCATION
+static StaticTask_t zb_task_tcb;
+static StackType_t zb_task_stack[CONFIG_ORP_APP_ZB_TASK_STACK_SIZE];
+#endif
+
+/* Poll Control server state, only touched from the Zigbee task or with the Zigbee lock held */
+static uint32_t check_in_interval_qs = ESP_ORP_CHECK_IN_INTERVAL_QS;
+static uint16_t fast_poll_timeout_qs = ESP_ORP_FAST_POLL_TIMEOUT_QS;
+
+/* Commissioning state, only touched from the Zigbee task or with the Zigbee lock held */
+static volatile bool network_joined = false;
+static uint32_t offline_readings = 0;
+
+/* Offline backlog, history entries stamped after backlog_cursor_us and up to backlog_end_us still need delivery */
+static int64_t delivered_us = 0;                /* timestamp of the last reading sent live */
+static int64_t backlog_cursor_us = 0;
+static int64_t backlog_end_us = INT64_MAX;      /* INT64_MAX while still offline */
+static bool backlog_pending = true;             /* readings taken before the first join count as backlog */
+static bool backlog_in_flight = false;          /* a backlog frame waits for its send status */
+static uint8_t backlog_tsn = 0;
+static int64_t backlog_sent_us = 0;             /* cursor once the frame in flight is delivered */
+static uint8_t last_channel = 0;                /* 0 when no channel is known yet */
+static uint8_t pending_mode = 0;                /* BDB mode of the scheduled retry, 0 when none */
+static bool commissioning_active = false;
+static uint16_t commissioning_attempt = 0;
+static uint32_t commissioning_backoff_ms = ESP_ORP_COMMISSIONING_BACKOFF_MIN_MS;
+static int64_t scan_start_us = 0;
+static int64_t scan_day_start_us = 0;
+static uint32_t scan_ms_today = 0;
+
+/* Probe health as last published in the Analog Input cluster */
+static orp_sensor_fault_t probe_fault = ORP_SENSOR_FAULT_NONE;
+static bool probe_fault_report_pending = false;
+
+/* SoC temperature last reported through the Temperature Measurement cluster */
+static int16_t reported_temperature_cdeg = ORP_SENSOR_TEMPERATURE_INVALID;
+
 /* Helper function to convert ZCL status code to string */
 static const char* esp_zb_zcl_status_to_string(uint8_t status_code)
 {
@@ -97,6 +144,139 @@ static esp_err_t esp_zb_power_save_init(void)
     return rc;
 }
 
+/* Long poll interval as currently configured in the Poll Control cluster */
+static uint32_t esp_app_long_poll_interval_get(void)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_POLL_CONTROL_LONG_POLL_INTERVAL_ID);
+    return attr && attr->data_p ? *(uint32_t *)attr->data_p : ESP_ORP_LONG_POLL_INTERVAL_QS;
+}
+
+static void esp_app_poll_control_check_in(uint8_t param)
+{
+    esp_zb_zcl_custom_cluster_cmd_req_t check_in_cmd = {
+        .zcl_basic_cmd.src_endpoint = HA_ESP_SENSOR_ENDPOINT,
+        .address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .custom_cmd_id = ESP_ORP_POLL_CONTROL_CHECK_IN_CMD_ID,
+        .data.type = ESP_ZB_ZCL_ATTR_TYPE_NULL,
+    };
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_TX);
+    esp_zb_zcl_custom_cluster_cmd_req(&check_in_cmd);
+    ESP_LOGI(TAG, "Send 'check-in' command");
+
+    /* Listen for the check-in response, the client decides whether to extend the window */
+    esp_zb_orp_fast_poll_request(ESP_ORP_FAST_POLL_POLL_CONTROL, fast_poll_timeout_qs * 250);
+
+    esp_zb_scheduler_alarm_cancel(esp_app_poll_control_check_in, 0);
+    if (check_in_interval_qs) {
+        esp_zb_scheduler_alarm(esp_app_poll_control_check_in, 0, check_in_interval_qs * 250);
+    }
+}
+
+static void esp_app_long_poll_interval_set(uint32_t long_poll_interval_qs)
+{
+    esp_zb_zdo_pim_set_long_poll_interval(long_poll_interval_qs * 250);
+    esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_POLL_CONTROL_LONG_POLL_INTERVAL_ID, &long_poll_interval_qs, false);
+    ESP_LOGI(TAG, "Long poll interval set to %lu ms", long_poll_interval_qs * 250);
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+    ESP_LOGI(TAG, "ORP_ENERGY %lld longpoll %lu", esp_timer_get_time() / 1000, long_poll_interval_qs * 250);
+#endif
+}
+
+static void esp_app_short_poll_interval_set(uint16_t short_poll_interval_qs)
+{
+    esp_zb_zdo_pim_set_fast_poll_interval(short_poll_interval_qs * 250);
+    esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_POLL_CONTROL_SHORT_POLL_INTERVAL_ID, &short_poll_interval_qs, false);
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+    ESP_LOGI(TAG, "ORP_ENERGY %lld shortpoll %d", esp_timer_get_time() / 1000, short_poll_interval_qs * 250);
+#endif
+}
+
+static void esp_app_poll_control_start(void)
+{
+    esp_app_short_poll_interval_set(ESP_ORP_SHORT_POLL_INTERVAL_QS);
+    /* Keep whatever a poll control client configured before a rejoin */
+    esp_app_long_poll_interval_set(esp_app_long_poll_interval_get());
+    /* Check in right away so a freshly joined device can be configured */
+    esp_app_poll_control_check_in(0);
+}
+
+static esp_err_t esp_app_poll_control_cmd_handler(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    const uint8_t *payload = message->data.value;
+
+    switch (message->info.command.id) {
+    case ESP_ORP_POLL_CONTROL_CHECK_IN_RSP_CMD_ID: {
+        ESP_RETURN_ON_FALSE(message->data.size >= 3, ESP_ERR_INVALID_ARG, TAG, "Malformed check-in response");
+        bool start_fast_polling = payload[0];
+        uint16_t timeout_qs = payload[1] | (payload[2] << 8);
+        if (!start_fast_polling) {
+            esp_zb_orp_fast_poll_release(ESP_ORP_FAST_POLL_POLL_CONTROL);
+            break;
+        }
+        if (timeout_qs == 0) {
+            timeout_qs = fast_poll_timeout_qs;
+        }
+        ESP_RETURN_ON_FALSE(timeout_qs <= ESP_ORP_FAST_POLL_TIMEOUT_MAX_QS, ESP_ERR_INVALID_ARG, TAG,
+                            "Fast poll timeout %d qs exceeds maximum %d qs", timeout_qs, ESP_ORP_FAST_POLL_TIMEOUT_MAX_QS);
+        esp_zb_orp_fast_poll_request(ESP_ORP_FAST_POLL_POLL_CONTROL, timeout_qs * 250);
+        break;
+    }
+    case ESP_ORP_POLL_CONTROL_FAST_POLL_STOP_CMD_ID:
+        /* Only ends the client's window, a running OTA transfer keeps polling */
+        esp_zb_orp_fast_poll_release(ESP_ORP_FAST_POLL_POLL_CONTROL);
+        break;
+    case ESP_ORP_POLL_CONTROL_SET_LONG_POLL_INTERVAL_CMD_ID: {
+        ESP_RETURN_ON_FALSE(message->data.size >= 4, ESP_ERR_INVALID_ARG, TAG, "Malformed set long poll interval");
+        uint32_t interval_qs = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+        ESP_RETURN_ON_FALSE(interval_qs >= ESP_ORP_LONG_POLL_INTERVAL_MIN_QS &&
+                            interval_qs <= ESP_ORP_CHECK_IN_INTERVAL_MAX_QS &&
+                            (check_in_interval_qs == 0 || interval_qs <= check_in_interval_qs),
+                            ESP_ERR_INVALID_ARG, TAG, "Long poll interval %lu qs out of range", interval_qs);
+        esp_app_long_poll_interval_set(interval_qs);
+        break;
+    }
+    case ESP_ORP_POLL_CONTROL_SET_SHORT_POLL_INTERVAL_CMD_ID: {
+        ESP_RETURN_ON_FALSE(message->data.size >= 2, ESP_ERR_INVALID_ARG, TAG, "Malformed set short poll interval");
+        uint16_t interval_qs = payload[0] | (payload[1] << 8);
+        ESP_RETURN_ON_FALSE(interval_qs > 0, ESP_ERR_INVALID_ARG, TAG, "Short poll interval must not be zero");
+        esp_app_short_poll_interval_set(interval_qs);
+        break;
+    }
+    default:
+        ESP_LOGW(TAG, "Unsupported poll control command 0x%x", message->info.command.id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+/* Called once the stack is done transmitting a ZCL command, whichever part of the application sent it */
+static void esp_app_zcl_send_status_handler(esp_zb_zcl_command_send_status_message_t message)
+{
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_IDLE);
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+    ESP_LOGI(TAG, "ORP_ENERGY %lld tx %d %d", esp_timer_get_time() / 1000, message.tsn, message.status);
+#endif
+    if (message.status != ESP_OK) {
+        ESP_LOGW(TAG, "ZCL command (tsn %d) send failed: %s", message.tsn, esp_err_to_name(message.status));
+    }
+    /* A lost backlog frame is sent again from the same cursor with the next reading */
+    if (backlog_in_flight && message.tsn == backlog_tsn) {
+        backlog_in_flight = false;
+        if (message.status == ESP_OK) {
+            backlog_cursor_us = backlog_sent_us;
+        }
+    }
+}
+
 /* ZCL attribute write callback for handling calibration updates */
 static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
 {
@@ -142,6 +322,62 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
                     ESP_LOGW(TAG, "Invalid data type for calibration attribute: %d", set_attr_message->attribute.data.type);
                     ret = ESP_ERR_INVALID_ARG;
                 }
+            } else if (set_attr_message->info.dst_endpoint == HA_ESP_SENSOR_ENDPOINT &&
+                       set_attr_message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL) {
+                /* Poll Control attributes written by the client */
+                if (set_attr_message->attribute.id == ESP_ZB_ZCL_ATTR_POLL_CONTROL_CHECK_IN_INTERVAL_ID) {
+                    uint32_t interval_qs = *(uint32_t *)set_attr_message->attribute.data.value;
+                    /* ZCL requires the check-in interval to be at least the long poll interval */
+                    if (interval_qs == 0 ||
+                        (interval_qs >= ESP_ORP_CHECK_IN_INTERVAL_MIN_QS && interval_qs <= ESP_ORP_CHECK_IN_INTERVAL_MAX_QS &&
+                         interval_qs >= esp_app_long_poll_interval_get())) {
+                        check_in_interval_qs = interval_qs;
+                        esp_zb_scheduler_alarm_cancel(esp_app_poll_control_check_in, 0);
+                        if (check_in_interval_qs) {
+                            esp_zb_scheduler_alarm(esp_app_poll_control_check_in, 0, check_in_interval_qs * 250);
+                        }
+                        ESP_LOGI(TAG, "Check-in interval set to %lu qs", check_in_interval_qs);
+                    } else {
+                        ret = ESP_ERR_INVALID_ARG;
+                    }
+                } else if (set_attr_message->attribute.id == ESP_ZB_ZCL_ATTR_POLL_CONTROL_FAST_POLL_TIMEOUT_ID) {
+                    uint16_t timeout_qs = *(uint16_t *)set_attr_message->attribute.data.value;
+                    if (timeout_qs > 0 && timeout_qs <= ESP_ORP_FAST_POLL_TIMEOUT_MAX_QS) {
+                        fast_poll_timeout_qs = timeout_qs;
+                    } else {
+                        ret = ESP_ERR_INVALID_ARG;
+                    }
+                }
+            }
+
+            /* Configuration writes tend to come in bursts, keep polling fast for the follow-ups */
+            esp_zb_orp_fast_poll_extend(ESP_ORP_FAST_POLL_POLL_CONTROL, ESP_ORP_CONFIG_FAST_POLL_MS);
+        }
+        break;
+    case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+        {
+            const esp_zb_zcl_ota_upgrade_value_message_t *ota_message = (esp_zb_zcl_ota_upgrade_value_message_t *)message;
+            ESP_RETURN_ON_FALSE(ota_message, ESP_FAIL, TAG, "Empty OTA upgrade message");
+            ret = esp_zb_orp_ota_upgrade_handler(ota_message);
+        }
+        break;
+    case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID:
+        {
+            const esp_zb_zcl_cmd_read_attr_resp_message_t *read_resp = (esp_zb_zcl_cmd_read_attr_resp_message_t *)message;
+            ESP_RETURN_ON_FALSE(read_resp, ESP_FAIL, TAG, "Empty read attributes response");
+            if (!esp_zb_orp_time_read_resp_handler(read_resp)) {
+                ESP_LOGI(TAG, "Read attributes response for cluster 0x%x", read_resp->info.cluster);
+            }
+        }
+        break;
+    case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        {
+            const esp_zb_zcl_custom_cluster_command_message_t *cmd_message = (esp_zb_zcl_custom_cluster_command_message_t *)message;
+            ESP_RETURN_ON_FALSE(cmd_message, ESP_FAIL, TAG, "Empty message");
+            if (cmd_message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_POLL_CONTROL) {
+                ret = esp_app_poll_control_cmd_handler(cmd_message);
+            } else {
+                ESP_LOGW(TAG, "Unhandled command 0x%x for cluster 0x%x", cmd_message->info.command.id, cmd_message->info.cluster);
             }
         }
         break;
@@ -149,7 +385,10 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
         {
             const esp_zb_zcl_cmd_default_resp_message_t *default_resp = (esp_zb_zcl_cmd_default_resp_message_t*)message;
             ESP_RETURN_ON_FALSE(default_resp, ESP_FAIL, TAG, "Empty default response message");
-            
+            if (esp_zb_orp_time_default_resp_handler(default_resp)) {
+                break;
+            }
+
             const char *status_str = esp_zb_zcl_status_to_string(default_resp->status_code);
             ESP_LOGI(TAG, "Default response received: endpoint(0x%x), cluster(0x%x), status_code(0x%x): %s",
                      default_resp->info.dst_endpoint, default_resp->info.cluster, 
@@ -163,55 +402,372 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     return ret;
 }
 
+static void esp_app_last_channel_load(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        nvs_get_u8(nvs_handle, NVS_LAST_CHANNEL_KEY, &last_channel);
+        nvs_close(nvs_handle);
+    }
+}
+
+static void esp_app_last_channel_save(uint8_t channel)
+{
+    nvs_handle_t nvs_handle;
+    if (channel == last_channel || nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_u8(nvs_handle, NVS_LAST_CHANNEL_KEY, channel) == ESP_OK && nvs_commit(nvs_handle) == ESP_OK) {
+        last_channel = channel;
+    }
+    nvs_close(nvs_handle);
+}
+
+/* Account a finished scan in the per-day scan time counter */
+static void esp_app_scan_time_account(void)
+{
+    if (!commissioning_active) {
+        return;
+    }
+    commissioning_active = false;
+
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - scan_day_start_us >= 24LL * 60 * 60 * 1000000) {
+        ESP_LOGI(TAG, "Commissioning scan time over the last day: %lu ms", scan_ms_today);
+        scan_ms_today = 0;
+        scan_day_start_us = now_us;
+    }
+    scan_ms_today += (uint32_t)((now_us - scan_start_us) / 1000);
+}
+
+static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
+{
+    pending_mode = 0;
+    if (mode_mask == ESP_ZB_BDB_MODE_NETWORK_STEERING) {
+        /* A coordinator that came back is almost always on the channel it used before */
+        bool full_scan = !last_channel || (commissioning_attempt % ESP_ORP_COMMISSIONING_FULL_SCAN_EVERY) == 0;
+        esp_zb_set_primary_network_channel_set(full_scan ? ESP_ZB_PRIMARY_CHANNEL_MASK : (1UL << last_channel));
+    }
+    commissioning_active = true;
+    scan_start_us = esp_timer_get_time();
+    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, ,
+                        TAG, "Failed to start Zigbee bdb commissioning");
+}
+
+static void esp_app_commissioning_retry(uint8_t mode_mask)
+{
+    esp_app_scan_time_account();
+    network_joined = false;
+
+    /* Exponential backoff with jitter so a fleet does not rescan in lockstep */
+    uint32_t jitter_ms = commissioning_backoff_ms * ESP_ORP_COMMISSIONING_JITTER_PCT / 100;
+    uint32_t delay_ms = commissioning_backoff_ms - jitter_ms + esp_random() % (2 * jitter_ms + 1);
+    commissioning_backoff_ms = MIN(commissioning_backoff_ms * 2, ESP_ORP_COMMISSIONING_BACKOFF_MAX_MS);
+    commissioning_attempt++;
+
+    ESP_LOGI(TAG, "Commissioning attempt %d failed, retrying in %lu ms (scan time today: %lu ms, %lu readings buffered)",
+             commissioning_attempt, delay_ms, scan_ms_today, offline_readings);
+    pending_mode = mode_mask;
+    esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, mode_mask, delay_ms);
+}
+
+/* Drop everything that needs the network and go back to the commissioning backoff */
+static void esp_app_network_lost(uint8_t mode_mask)
+{
+    network_joined = false;
+    /* Keep the readings already sent live out of the entries the backlog delivers */
+    orp_sensor_history_flush();
+    if (!backlog_pending) {
+        backlog_cursor_us = delivered_us;
+        backlog_pending = true;
+    }
+    backlog_end_us = INT64_MAX;
+    backlog_in_flight = false;
+    esp_zb_scheduler_alarm_cancel(esp_app_poll_control_check_in, 0);
+    esp_zb_orp_fast_poll_release(ESP_ORP_FAST_POLL_POLL_CONTROL);
+    esp_zb_orp_time_sync_stop();
+    esp_app_commissioning_retry(mode_mask);
+}
+
+static void esp_app_network_joined(void)
+{
+    esp_app_scan_time_account();
+    network_joined = true;
+    commissioning_attempt = 0;
+    commissioning_backoff_ms = ESP_ORP_COMMISSIONING_BACKOFF_MIN_MS;
+    esp_app_last_channel_save(esp_zb_get_current_channel());
+    esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
+    if (backlog_pending) {
+        /* Readings from here on are sent live, the backlog ends with the interval they would have joined */
+        size_t entries = 0;
+        orp_sensor_history_flush();
+        backlog_end_us = esp_timer_get_time();
+        orp_sensor_get_history(backlog_cursor_us, NULL, 0, &entries);
+        ESP_LOGI(TAG, "Back online after %lu offline readings, %u history entries to deliver", offline_readings,
+                 (unsigned)entries);
+        if (entries >= CONFIG_ORP_SENSOR_HISTORY_DEPTH) {
+            ESP_LOGW(TAG, "Sample history overflowed while offline, readings older than %d minutes were dropped",
+                     CONFIG_ORP_SENSOR_HISTORY_DEPTH * CONFIG_ORP_SENSOR_HISTORY_INTERVAL_S / 60);
+        }
+        offline_readings = 0;
+    }
+    esp_app_poll_control_start();
+    esp_zb_orp_time_sync_start();
+    /* Reaching the network proves a freshly upgraded image works */
+    esp_zb_orp_ota_mark_valid();
+}
+
+/* A reboot only restores the network state from NVRAM, check that the coordinator still answers */
+static void esp_app_network_verify_cb(esp_zb_zdp_status_t zdo_status, esp_zb_zdo_ieee_addr_rsp_t *resp, void *user_ctx)
+{
+    if (zdo_status == ESP_ZB_ZDP_STATUS_SUCCESS) {
+        ESP_LOGI(TAG, "Coordinator reachable after reboot");
+        esp_app_network_joined();
+    } else {
+        ESP_LOGW(TAG, "Coordinator not reachable after reboot (ZDP status 0x%x)", zdo_status);
+        esp_app_network_lost(ESP_ZB_BDB_MODE_INITIALIZATION);
+    }
+}
+
+static void esp_app_network_verify(void)
+{
+    esp_zb_zdo_ieee_addr_req_param_t ieee_req = {
+        .dst_nwk_addr = 0x0000,
+        .addr_of_interest = 0x0000,
+        .request_type = 0,
+        .start_index = 0,
+    };
+    esp_zb_zdo_ieee_addr_req(&ieee_req, esp_app_network_verify_cb, NULL);
+    /* Poll for the response instead of waiting for the next long poll */
+    esp_zb_zdo_pim_start_turbo_poll_packets(1);
+}
+
+/* Send an attribute report of the sensor endpoint to bound clients, call with the Zigbee lock held */
+static esp_err_t esp_app_attr_report(uint16_t cluster_id, uint16_t attr_id)
+{
+    esp_zb_zcl_report_attr_cmd_t report_attr_cmd = {0};
+    report_attr_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT;
+    report_attr_cmd.attributeID = attr_id;
+    report_attr_cmd.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI;
+    report_attr_cmd.clusterID = cluster_id;
+    report_attr_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_SENSOR_ENDPOINT;
+
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_TX);
+    esp_err_t ret = esp_zb_zcl_report_attr_cmd_req(&report_attr_cmd);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send attribute 0x%x report: %s", attr_id, esp_err_to_name(ret));
+        orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_IDLE);
+    }
+    return ret;
+}
+
+/* Append one ORP log record to a ZCL octet string, whose first byte holds the length */
+static void esp_app_log_record_add(uint8_t *records, uint32_t utc_s, int orp_mv, uint8_t fault)
+{
+    uint8_t *record = records + 1 + records[0];
+    record[0] = utc_s & 0xff;
+    record[1] = (utc_s >> 8) & 0xff;
+    record[2] = (utc_s >> 16) & 0xff;
+    record[3] = (utc_s >> 24) & 0xff;
+    record[4] = (uint16_t)orp_mv & 0xff;
+    record[5] = ((uint16_t)orp_mv >> 8) & 0xff;
+    record[6] = fault;
+    records[0] += ESP_ORP_LOG_RECORD_SIZE;
+}
+
+/* Send ORP log records to bound clients, call with the Zigbee lock held
+ *
+ * The request only queues the frame and returns its ZCL sequence number, delivery is reported to
+ * esp_app_zcl_send_status_handler() which also returns the radio to idle.
+ */
+static uint8_t esp_app_log_records_send(uint8_t cmd_id, uint8_t *records)
+{
+    esp_zb_zcl_custom_cluster_cmd_req_t log_cmd = {
+        .zcl_basic_cmd.src_endpoint = HA_ESP_SENSOR_ENDPOINT,
+        .address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ESP_ORP_LOG_CLUSTER_ID,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .custom_cmd_id = cmd_id,
+        .data = {
+            .type = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+            .size = 1 + records[0],
+            .value = records,
+        },
+    };
+
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_TX);
+    return esp_zb_zcl_custom_cluster_cmd_req(&log_cmd);
+}
+
+/* Send the next history entries missed while offline, call with the Zigbee lock held once time is synced */
+static void esp_app_backlog_send(void)
+{
+    orp_sensor_history_entry_t entries[ESP_ORP_LOG_MAX_RECORDS];
+    size_t count = 0;
+    if (backlog_in_flight) {
+        return;
+    }
+    if (orp_sensor_get_history(backlog_cursor_us, entries, ESP_ORP_LOG_MAX_RECORDS, &count) != ESP_OK) {
+        return;
+    }
+
+    uint8_t records[1 + ESP_ORP_LOG_MAX_RECORDS * ESP_ORP_LOG_RECORD_SIZE] = {0};
+    int64_t last_us = backlog_cursor_us;
+    for (size_t i = 0; i < count && (int64_t)entries[i].timestamp_s * 1000000 <= backlog_end_us; i++) {
+        last_us = (int64_t)entries[i].timestamp_s * 1000000;
+        esp_app_log_record_add(records, esp_zb_orp_time_to_utc(last_us), entries[i].orp_mv, entries[i].fault);
+    }
+    if (!records[0]) {
+        backlog_pending = false;
+        ESP_LOGI(TAG, "Offline backlog delivered");
+        return;
+    }
+    backlog_tsn = esp_app_log_records_send(ESP_ORP_LOG_BACKLOG_CMD_ID, records);
+    backlog_sent_us = last_us;
+    backlog_in_flight = true;
+}
+
+/* Mirror the probe fault into StatusFlags, OutOfService and Reliability, call with the Zigbee lock held */
+static void esp_app_probe_health_update(orp_sensor_fault_t fault)
+{
+    if (fault == probe_fault) {
+        return;
+    }
+    probe_fault = fault;
+    probe_fault_report_pending = true;
+
+    /* Railed or stuck readings carry no information about the water */
+    bool out_of_service = fault == ORP_SENSOR_FAULT_OVER_RANGE || fault == ORP_SENSOR_FAULT_UNDER_RANGE ||
+                          fault == ORP_SENSOR_FAULT_STUCK;
+    uint8_t status_flags = 0;
+    if (fault == ORP_SENSOR_FAULT_OVER_RANGE || fault == ORP_SENSOR_FAULT_UNDER_RANGE) {
+        status_flags |= ESP_ORP_STATUS_FLAG_IN_ALARM;
+    }
+    if (fault != ORP_SENSOR_FAULT_NONE) {
+        status_flags |= ESP_ORP_STATUS_FLAG_FAULT;
+    }
+    if (out_of_service) {
+        status_flags |= ESP_ORP_STATUS_FLAG_OUT_OF_SERVICE;
+    }
+    uint8_t reliability = fault;
+
+    esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_ANALOG_INPUT_STATUS_FLAGS_ID, &status_flags, false);
+    esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_ANALOG_INPUT_OUT_OF_SERVICE_ID, &out_of_service, false);
+    esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+        ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        ESP_ZB_ZCL_ATTR_ANALOG_INPUT_RELIABILITY_ID, &reliability, false);
+
+    if (fault == ORP_SENSOR_FAULT_NONE) {
+        ESP_LOGI(TAG, "ORP probe healthy again");
+    } else {
+        ESP_LOGW(TAG, "ORP probe fault %d detected (status flags 0x%x)", fault, status_flags);
+    }
+}
+
 static void esp_app_buttons_handler(switch_func_pair_t *button_func_pair)
 {
+    if (!network_joined) {
+        /* Skip the remaining backoff and try to join right away */
+        esp_zb_lock_acquire(portMAX_DELAY);
+        if (pending_mode) {
+            uint8_t mode = pending_mode;
+            esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, mode);
+            commissioning_attempt = 0;
+            commissioning_backoff_ms = ESP_ORP_COMMISSIONING_BACKOFF_MIN_MS;
+            bdb_start_top_level_commissioning_cb(mode);
+            ESP_EARLY_LOGI(TAG, "Button pressed while offline, commissioning now");
+        }
+        esp_zb_lock_release();
+        return;
+    }
+
     if (button_func_pair->func == SWITCH_ONOFF_TOGGLE_CONTROL) {
         /* Send report attributes command */
-        esp_zb_zcl_report_attr_cmd_t report_attr_cmd = {0};
-        report_attr_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT;
-        report_attr_cmd.attributeID = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID;
-        report_attr_cmd.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI;
-        report_attr_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-        report_attr_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_SENSOR_ENDPOINT;
-
         esp_zb_lock_acquire(portMAX_DELAY);
-        esp_zb_zcl_report_attr_cmd_req(&report_attr_cmd);
+        esp_app_attr_report(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID);
+        /* A button press usually precedes reconfiguration from the coordinator */
+        esp_zb_orp_fast_poll_extend(ESP_ORP_FAST_POLL_POLL_CONTROL, fast_poll_timeout_qs * 250);
         esp_zb_lock_release();
         ESP_EARLY_LOGI(TAG, "Send 'report attributes' command");
     }
 }
 
-static void esp_app_orp_sensor_handler(int orp_mv)
+static void esp_app_orp_sensor_handler(const orp_sensor_reading_t *reading)
 {
-    float orp_value = (float)orp_mv;
+    float orp_value = (float)reading->orp_mv;
+
+    esp_zb_lock_acquire(portMAX_DELAY);
+    esp_app_probe_health_update(reading->fault);
+    esp_zb_lock_release();
+
+    if (!network_joined) {
+        /* The driver keeps the reading in its history, it is delivered after the next join */
+        offline_readings++;
+        ESP_LOGI(TAG, "ORP sensor value: %d mV [OFFLINE]", reading->orp_mv);
+        return;
+    }
     
     /* Update ORP sensor measured value */
     esp_zb_lock_acquire(portMAX_DELAY);
     esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
         ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
         ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID, &orp_value, false);
-    
-    /* Always send report every 15 seconds */
-    esp_zb_zcl_report_attr_cmd_t report_attr_cmd = {0};
-    report_attr_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT;
-    report_attr_cmd.attributeID = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID;
-    report_attr_cmd.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI;
-    report_attr_cmd.clusterID = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT;
-    report_attr_cmd.zcl_basic_cmd.src_endpoint = HA_ESP_SENSOR_ENDPOINT;
-    
-    esp_err_t ret = esp_zb_zcl_report_attr_cmd_req(&report_attr_cmd);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to send attribute report: %s", esp_err_to_name(ret));
+
+    /* Probe alarms go out with this reading instead of waiting for the periodic report of the flags.
+     * Reliability and OutOfService are not reportable, the fault code itself travels in the log record. */
+    if (probe_fault_report_pending &&
+        esp_app_attr_report(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_STATUS_FLAGS_ID) == ESP_OK) {
+        probe_fault_report_pending = false;
+    }
+
+    /* Temperature goes out in the same awake window as the reading, but only once it has moved */
+    if (reading->temperature_cdeg != ORP_SENSOR_TEMPERATURE_INVALID) {
+        int16_t temperature = reading->temperature_cdeg;
+        esp_zb_zcl_set_attribute_val(HA_ESP_SENSOR_ENDPOINT,
+            ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &temperature, false);
+        if (reported_temperature_cdeg == ORP_SENSOR_TEMPERATURE_INVALID ||
+            abs(temperature - reported_temperature_cdeg) >= ESP_ORP_TEMPERATURE_REPORT_DELTA_CDEG) {
+            if (esp_app_attr_report(ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID) == ESP_OK) {
+                reported_temperature_cdeg = temperature;
+            }
+        }
+    }
+
+    /* Always send the reading every 15 seconds, stamped with when it was sampled once the clock is synced */
+    uint32_t sample_time = esp_zb_orp_time_to_utc(reading->timestamp_us);
+    if (sample_time != ESP_ORP_TIME_INVALID) {
+        uint8_t records[1 + ESP_ORP_LOG_RECORD_SIZE] = {0};
+        esp_app_log_record_add(records, sample_time, reading->orp_mv, reading->fault);
+        esp_app_log_records_send(ESP_ORP_LOG_READING_CMD_ID, records);
+        /* Catch up on what was missed while offline, one frame per reading to spread the airtime */
+        if (backlog_pending) {
+            esp_app_backlog_send();
+        }
+    } else {
+        esp_app_attr_report(ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID);
     }
+    delivered_us = reading->timestamp_us;
     esp_zb_lock_release();
     
-    ESP_LOGI(TAG, "ORP sensor value: %d mV [REPORTED]", orp_mv);
-}
+    ESP_LOGI(TAG, "ORP sensor value: %d mV (%d/%d samples hit TX, fault %d) [REPORTED]",
+             reading->orp_mv, reading->tx_collisions, reading->samples, reading->fault);
 
-static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
-{
-    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, ,
-                        TAG, "Failed to start Zigbee bdb commissioning");
+#if CONFIG_ORP_SENSOR_STACK_REPORT
+    /* Zigbee_main has no periodic hook of its own, sample its stack from here */
+    static UBaseType_t zb_min_free_stack = CONFIG_ORP_APP_ZB_TASK_STACK_SIZE;
+    UBaseType_t zb_free_stack = zb_task_handle ? uxTaskGetStackHighWaterMark(zb_task_handle) : zb_min_free_stack;
+    if (zb_free_stack < zb_min_free_stack) {
+        zb_min_free_stack = zb_free_stack;
+        ESP_LOGI(TAG, "Zigbee_main stack high-water mark: %u of %d bytes free",
+                 (unsigned)zb_free_stack, CONFIG_ORP_APP_ZB_TASK_STACK_SIZE);
+    }
+#endif
 }
 
 static esp_err_t deferred_driver_init(void)
@@ -237,24 +793,28 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     switch (sig_type) {
     case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP:
         ESP_LOGI(TAG, "Initialize Zigbee stack");
-        esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_INITIALIZATION);
+        esp_app_last_channel_load();
+        scan_day_start_us = esp_timer_get_time();
+        bdb_start_top_level_commissioning_cb(ESP_ZB_BDB_MODE_INITIALIZATION);
         break;
     case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:
     case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:
+        /* Keep sampling into the local history even when the network is absent */
+        ESP_LOGI(TAG, "Deferred driver initialization %s", deferred_driver_init() ? "failed" : "successful");
         if (err_status == ESP_OK) {
-            ESP_LOGI(TAG, "Deferred driver initialization %s", deferred_driver_init() ? "failed" : "successful");
             ESP_LOGI(TAG, "Device started up in%s factory-reset mode", esp_zb_bdb_is_factory_new() ? "" : " non");
             if (esp_zb_bdb_is_factory_new()) {
+                esp_app_scan_time_account();
                 ESP_LOGI(TAG, "Start network steering");
-                esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+                bdb_start_top_level_commissioning_cb(ESP_ZB_BDB_MODE_NETWORK_STEERING);
             } else {
                 ESP_LOGI(TAG, "Device rebooted");
+                esp_app_network_verify();
             }
         } else {
             ESP_LOGW(TAG, "%s failed with status: %s, retrying", esp_zb_zdo_signal_to_string(sig_type),
                      esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb,
-                                   ESP_ZB_BDB_MODE_INITIALIZATION, 1000);
+            esp_app_commissioning_retry(ESP_ZB_BDB_MODE_INITIALIZATION);
         }
         break;
     case ESP_ZB_BDB_SIGNAL_STEERING:
@@ -265,9 +825,31 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
                      extended_pan_id[7], extended_pan_id[6], extended_pan_id[5], extended_pan_id[4],
                      extended_pan_id[3], extended_pan_id[2], extended_pan_id[1], extended_pan_id[0],
                      esp_zb_get_pan_id(), esp_zb_get_current_channel(), esp_zb_get_short_address());
+            esp_app_network_joined();
         } else {
             ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_NETWORK_STEERING, 1000);
+            esp_app_commissioning_retry(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+        }
+        break;
+    case ESP_ZB_ZDO_SIGNAL_LEAVE:
+        {
+            esp_zb_zdo_signal_leave_params_t *leave_params = (esp_zb_zdo_signal_leave_params_t *)esp_zb_app_signal_get_params(p_sg_p);
+            bool rejoin = leave_params && leave_params->leave_type == ESP_ZB_NWK_LEAVE_TYPE_REJOIN;
+            ESP_LOGW(TAG, "Left the network (%s)", rejoin ? "rejoin requested" : "removed");
+            /* Removed devices have to be steered into a network again, a rejoin keeps the network keys */
+            esp_app_network_lost(rejoin ? ESP_ZB_BDB_MODE_INITIALIZATION : ESP_ZB_BDB_MODE_NETWORK_STEERING);
+        }
+        break;
+    case ESP_ZB_NLME_STATUS_INDICATION:
+        {
+            esp_zb_zdo_signal_nwk_status_indication_params_t *status_params =
+                (esp_zb_zdo_signal_nwk_status_indication_params_t *)esp_zb_app_signal_get_params(p_sg_p);
+            ESP_LOGI(TAG, "ZDO signal: %s (0x%x), nwk status: 0x%x", esp_zb_zdo_signal_to_string(sig_type), sig_type,
+                     status_params ? status_params->status : 0xff);
+            if (network_joined && status_params && status_params->status == ESP_ZB_NWK_COMMAND_STATUS_PARENT_LINK_FAILURE) {
+                ESP_LOGW(TAG, "Lost the parent, rejoining");
+                esp_app_network_lost(ESP_ZB_BDB_MODE_INITIALIZATION);
+            }
         }
         break;
       case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
@@ -278,7 +860,16 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
             } else {
                 ESP_LOGI(TAG, "Zigbee can sleep");
             }
+            /* Nothing queued for the radio, a good moment for an ADC burst */
+            orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_IDLE);
+#if CONFIG_ORP_SENSOR_ENERGY_TRACE
+            /* esp_timer keeps counting through light sleep, so this is the time actually slept */
+            int64_t sleep_start_us = esp_timer_get_time();
+            esp_zb_sleep_now();
+            ESP_LOGI(TAG, "ORP_ENERGY %lld sleep %lld", sleep_start_us / 1000, esp_timer_get_time() - sleep_start_us);
+#else
             esp_zb_sleep_now();
+#endif
         }
         break;
     default:
@@ -297,6 +888,10 @@ static esp_zb_cluster_list_t *custom_orp_sensor_clusters_create(esp_zb_analog_in
     
     /* Create analog input cluster and add calibration attribute */
     esp_zb_attribute_list_t *analog_input_cluster = esp_zb_analog_input_cluster_create(analog_input_cfg);
+
+    /* Reliability carries the probe fault code next to status_flags / out_of_service */
+    uint8_t reliability_default = ORP_SENSOR_FAULT_NONE;
+    ESP_ERROR_CHECK(esp_zb_analog_input_cluster_add_attr(analog_input_cluster, ESP_ZB_ZCL_ATTR_ANALOG_INPUT_RELIABILITY_ID, &reliability_default));
     
     /* Add calibration attribute to analog input cluster using maxPresentValue */
     float calibration_default = 0.0f;  /* Default calibration offset */
@@ -307,7 +902,39 @@ static esp_zb_cluster_list_t *custom_orp_sensor_clusters_create(esp_zb_analog_in
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_basic_cluster(cluster_list, basic_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(cluster_list, esp_zb_identify_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_identify_cluster(cluster_list, esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY), ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_time_cluster(cluster_list, esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TIME), ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_analog_input_cluster(cluster_list, analog_input_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
+#if CONFIG_ORP_SENSOR_TEMP_COMPENSATION
+    /* SoC temperature the ORP readings are compensated with */
+    esp_zb_temperature_meas_cluster_cfg_t temperature_meas_cfg = {
+        .measured_value = ESP_ZB_ZCL_TEMP_MEASUREMENT_MEASURED_VALUE_UNKNOWN,
+        .min_value = ESP_ORP_TEMPERATURE_MIN_CDEG,
+        .max_value = ESP_ORP_TEMPERATURE_MAX_CDEG,
+    };
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_temperature_meas_cluster(cluster_list, esp_zb_temperature_meas_cluster_create(&temperature_meas_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+#endif
+
+    /* Poll Control lets the coordinator open fast-poll windows while the device long polls by default */
+    esp_zb_poll_control_cluster_cfg_t poll_control_cfg = {
+        .check_in_interval = ESP_ORP_CHECK_IN_INTERVAL_QS,
+        .long_poll_interval = ESP_ORP_LONG_POLL_INTERVAL_QS,
+        .short_poll_interval = ESP_ORP_SHORT_POLL_INTERVAL_QS,
+        .fast_poll_timeout = ESP_ORP_FAST_POLL_TIMEOUT_QS,
+        .check_in_interval_min = ESP_ORP_CHECK_IN_INTERVAL_MIN_QS,
+        .long_poll_interval_min = ESP_ORP_LONG_POLL_INTERVAL_MIN_QS,
+        .fast_poll_timeout_max = ESP_ORP_FAST_POLL_TIMEOUT_MAX_QS,
+    };
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_poll_control_cluster(cluster_list, esp_zb_poll_control_cluster_create(&poll_control_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
+    /* ORP log: readings paired with their sample time in one command */
+    esp_zb_attribute_list_t *log_cluster = esp_zb_zcl_attr_list_create(ESP_ORP_LOG_CLUSTER_ID);
+    uint8_t log_format = ESP_ORP_LOG_FORMAT_VERSION;
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(log_cluster, ESP_ORP_LOG_ATTR_FORMAT_ID, ESP_ZB_ZCL_ATTR_TYPE_U8,
+        ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &log_format));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cluster_list, log_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
+    esp_zb_orp_ota_cluster_add(cluster_list);
     return cluster_list;
 }
 
@@ -345,6 +972,9 @@ static void esp_zb_task(void *pvParameters)
     /* Register ZCL attribute write handler */
     esp_zb_core_action_handler_register(zb_action_handler);
 
+    /* Track ZCL transmissions so the ORP driver can sample while the radio is quiet */
+    esp_zb_zcl_command_send_status_handler_register(esp_app_zcl_send_status_handler);
+
     /* Initialize calibration attribute with current value from NVS */
     int current_calibration = 0;
     if (orp_sensor_get_calibration(&current_calibration) == ESP_OK) {
@@ -355,30 +985,27 @@ static void esp_zb_task(void *pvParameters)
         ESP_LOGI(TAG, "Initialized calibration attribute with current value: %d mV", current_calibration);
     }
 
-    /* Config the reporting info for automatic reporting */
+    /* Readings go out as Reading commands of the log cluster, stamped with their sample time, or as explicit
+     * present value reports until the clock is synced. Disable automatic present value reports, a maximum
+     * interval of 0xffff turns them off, so the stack does not also send them once the attribute is bound. */
     esp_zb_zcl_reporting_info_t reporting_info = {
         .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
         .ep = HA_ESP_SENSOR_ENDPOINT,
         .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ANALOG_INPUT,
         .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
         .dst.profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .u.send_info.min_interval = ESP_ORP_SENSOR_UPDATE_INTERVAL,     /* Minimum interval matches sensor update */
-        .u.send_info.max_interval = ESP_ORP_SENSOR_UPDATE_INTERVAL * 2, /* Maximum interval is 2x sensor update */
+        .u.send_info.min_interval = ESP_ORP_SENSOR_UPDATE_INTERVAL,
+        .u.send_info.max_interval = 0xffff,
         .u.send_info.def_min_interval = ESP_ORP_SENSOR_UPDATE_INTERVAL,
-        .u.send_info.def_max_interval = ESP_ORP_SENSOR_UPDATE_INTERVAL * 2,
-        .u.send_info.delta.u16 = 0,        /* Always report (no delta threshold) */
+        .u.send_info.def_max_interval = 0xffff,
+        .u.send_info.delta.u16 = 0,
         .attr_id = ESP_ZB_ZCL_ATTR_ANALOG_INPUT_PRESENT_VALUE_ID,
         .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
     };
 
     esp_err_t ret = esp_zb_zcl_update_reporting_info(&reporting_info);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to configure reporting info: %s", esp_err_to_name(ret));
-    } else {
-        ESP_LOGI(TAG, "Configured automatic reporting: min=%ds, max=%ds, delta=%dmV", 
-                 reporting_info.u.send_info.min_interval, 
-                 reporting_info.u.send_info.max_interval,
-                 reporting_info.u.send_info.delta.u16);
+        ESP_LOGW(TAG, "Failed to disable present value reporting: %s", esp_err_to_name(ret));
     }
 
     esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
@@ -398,5 +1025,10 @@ void app_main(void)
     /* load Zigbee platform config to initialization */
     ESP_ERROR_CHECK(esp_zb_platform_config(&config));
 
-    xTaskCreate(esp_zb_task, "Zigbee_main", 4096, NULL, 5, NULL);
+#if CONFIG_ORP_SENSOR_STATIC_ALLOCATION
+    zb_task_handle = xTaskCreateStatic(esp_zb_task, "Zigbee_main", CONFIG_ORP_APP_ZB_TASK_STACK_SIZE, NULL, 5,
+                                       zb_task_stack, &zb_task_tcb);
+#else
+    xTaskCreate(esp_zb_task, "Zigbee_main", CONFIG_ORP_APP_ZB_TASK_STACK_SIZE, NULL, 5, &zb_task_handle);
+#endif
 }
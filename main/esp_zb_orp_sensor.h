@@ -21,16 +21,59 @@
 /* Zigbee configuration */
 #define INSTALLCODE_POLICY_ENABLE       false   /* enable the install code policy for security */
 #define ED_AGING_TIMEOUT                ESP_ZB_ED_AGING_TIMEOUT_64MIN
-#define ED_KEEP_ALIVE                   (ESP_ORP_SENSOR_UPDATE_INTERVAL * 1000)
+#define ED_KEEP_ALIVE                   (ESP_ORP_LONG_POLL_INTERVAL_QS * 250)   /* keep-alive follows the long poll interval */
 #define HA_ESP_SENSOR_ENDPOINT          10      /* esp ORP sensor device endpoint, used for ORP measurement */
 #define ESP_ZB_PRIMARY_CHANNEL_MASK     ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK    /* Zigbee primary channel mask use in the example */
 
 
+/* Commissioning retry policy while no network is reachable */
+#define ESP_ORP_COMMISSIONING_BACKOFF_MIN_MS    (1000)              /* First retry after 1 second */
+#define ESP_ORP_COMMISSIONING_BACKOFF_MAX_MS    (30 * 60 * 1000)    /* Retry at least every 30 minutes */
+#define ESP_ORP_COMMISSIONING_JITTER_PCT        (25)                /* Randomise each delay by +/-25% */
+#define ESP_ORP_COMMISSIONING_FULL_SCAN_EVERY   (4)                 /* Every 4th steering attempt scans all channels */
+
+/* Poll Control cluster configuration, all intervals in quarter seconds as defined by ZCL */
+#define ESP_ORP_CHECK_IN_INTERVAL_QS        (30 * 60 * 4)   /* Check-in with the poll control client every 30 minutes */
+#define ESP_ORP_CHECK_IN_INTERVAL_MIN_QS    (60 * 4)        /* Smallest check-in interval a client may write */
+#define ESP_ORP_CHECK_IN_INTERVAL_MAX_QS    (0x6E0000)      /* ZCL maximum for check-in and long poll intervals (~8 days) */
+#define ESP_ORP_LONG_POLL_INTERVAL_QS       (150 * 4)       /* Poll the parent every 150 seconds while idle */
+#define ESP_ORP_LONG_POLL_INTERVAL_MIN_QS   (5 * 4)         /* Smallest long poll interval a client may request */
+#define ESP_ORP_SHORT_POLL_INTERVAL_QS      (2)             /* Poll every 0.5 seconds inside a fast-poll window */
+#define ESP_ORP_FAST_POLL_TIMEOUT_QS        (10 * 4)        /* Default fast-poll window after check-in or button press */
+#define ESP_ORP_FAST_POLL_TIMEOUT_MAX_QS    (120 * 4)       /* Longest fast-poll window a client may request */
+#define ESP_ORP_CONFIG_FAST_POLL_MS         (5000)          /* Keep fast polling this long after a configuration write */
+
+/* Poll Control cluster command identifiers */
+#define ESP_ORP_POLL_CONTROL_CHECK_IN_CMD_ID                0x00    /* server to client */
+#define ESP_ORP_POLL_CONTROL_CHECK_IN_RSP_CMD_ID            0x00    /* client to server */
+#define ESP_ORP_POLL_CONTROL_FAST_POLL_STOP_CMD_ID          0x01
+#define ESP_ORP_POLL_CONTROL_SET_LONG_POLL_INTERVAL_CMD_ID  0x02
+#define ESP_ORP_POLL_CONTROL_SET_SHORT_POLL_INTERVAL_CMD_ID 0x03
+
+/* Manufacturer-specific ORP log cluster, carries readings together with the UTC time they were sampled at */
+#define ESP_ORP_LOG_CLUSTER_ID              (0xFC01)
+#define ESP_ORP_LOG_ATTR_FORMAT_ID          (0x0000)    /* Record format version, read-only */
+#define ESP_ORP_LOG_FORMAT_VERSION          (1)
+#define ESP_ORP_LOG_READING_CMD_ID          (0x00)      /* server to client: the reading just taken */
+#define ESP_ORP_LOG_BACKLOG_CMD_ID          (0x01)      /* server to client: history entries averaged while offline */
+#define ESP_ORP_LOG_RECORD_SIZE             (7)         /* UTCTime (4), ORP in mV (2), probe fault (1), little endian */
+#define ESP_ORP_LOG_MAX_RECORDS             (8)         /* Records per command, keeps the frame unfragmented */
+
 /* ORP calibration using maxPresentValue attribute in Analog Input cluster */
 #define ESP_ZB_ZCL_ATTR_ORP_CALIBRATION_ID    ESP_ZB_ZCL_ATTR_ANALOG_INPUT_MAX_PRESENT_VALUE_ID  /* Use maxPresentValue for calibration */
 #define ESP_ORP_CALIBRATION_MIN_VALUE   (-500)  /* Minimum calibration offset (millivolts) */
 #define ESP_ORP_CALIBRATION_MAX_VALUE   (500)   /* Maximum calibration offset (millivolts) */
 
+/* Temperature Measurement cluster, values in 0.01 degC */
+#define ESP_ORP_TEMPERATURE_MIN_CDEG            (-1000)     /* Lower end of the SoC temperature sensor range */
+#define ESP_ORP_TEMPERATURE_MAX_CDEG            (8000)      /* Upper end of the SoC temperature sensor range */
+#define ESP_ORP_TEMPERATURE_REPORT_DELTA_CDEG   (50)        /* Report the temperature after it moved 0.5 degC */
+
+/* Analog Input StatusFlags bits */
+#define ESP_ORP_STATUS_FLAG_IN_ALARM        (1 << 0)    /* Reading outside the probe range */
+#define ESP_ORP_STATUS_FLAG_FAULT           (1 << 1)    /* Reliability is not NO_FAULT_DETECTED */
+#define ESP_ORP_STATUS_FLAG_OUT_OF_SERVICE  (1 << 3)    /* Present value does not track the probe */
+
 /* Attribute values in ZCL string format
  * The string should be started with the length of its own.
  */
@@ -0,0 +1,223 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "esp_zb_orp_time.h"
+#include "esp_zb_orp_sensor.h"
+#include "orp_sensor_driver.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <sys/param.h>
+
+/**
+ * @brief:
+ * Keeps a mapping from esp_timer time, which keeps running through light sleep,
+ * to UTC read from the coordinator's Time cluster.
+ *
+ * @note:
+ * UTC = ref_utc + elapsed + elapsed * drift, with elapsed counted from the last
+ * sync. Drift is measured between syncs at least six hours apart. The next sync is
+ * scheduled for when the estimated error would reach ESP_ORP_TIME_MAX_ERROR_MS,
+ * so a device with measured drift only talks to the coordinator a few times a day.
+ * Unanswered requests are retried with exponential backoff, and a coordinator
+ * without a Time server is not asked again until the next join.
+ *
+ */
+
+static const char *TAG = "ESP_ZB_ORP_TIME";
+
+/* current mapping */
+static bool synced = false;
+static int64_t ref_mono_us;
+static int64_t ref_utc_us;
+static int32_t drift_ppb = 0;
+static bool drift_known = false;
+
+/* older sync point the drift is measured against */
+static bool anchor_valid = false;
+static int64_t anchor_mono_us;
+static int64_t anchor_utc_us;
+
+/* outstanding read request */
+static bool request_pending = false;
+static int64_t request_mono_us;
+static uint32_t retry_s = ESP_ORP_TIME_SYNC_RETRY_S;
+static bool server_unsupported = false;
+
+static void esp_zb_orp_time_sync_request(uint8_t param)
+{
+    if (server_unsupported) {
+        return;
+    }
+
+    uint16_t attr_id = ESP_ZB_ZCL_ATTR_TIME_TIME_ID;
+    esp_zb_zcl_read_attr_cmd_t read_req = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = ESP_ORP_TIME_SERVER_ADDR,
+            .dst_endpoint = ESP_ORP_TIME_SERVER_ENDPOINT,
+            .src_endpoint = HA_ESP_SENSOR_ENDPOINT,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = ESP_ZB_ZCL_CLUSTER_ID_TIME,
+        .attr_number = 1,
+        .attr_field = &attr_id,
+    };
+
+    request_mono_us = esp_timer_get_time();
+    request_pending = true;
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_TX);
+    esp_zb_zcl_read_attr_cmd_req(&read_req);
+    /* Poll fast until the response is in, the round trip bounds the sync error */
+    esp_zb_zdo_pim_start_turbo_poll_packets(1);
+
+    /* Retried only if no response arrives, back off so an absent server costs little */
+    esp_zb_scheduler_alarm_cancel(esp_zb_orp_time_sync_request, 0);
+    esp_zb_scheduler_alarm(esp_zb_orp_time_sync_request, 0, retry_s * 1000);
+    retry_s = MIN(retry_s * 2, ESP_ORP_TIME_SYNC_MAX_INTERVAL_S);
+}
+
+static void esp_zb_orp_time_server_unsupported(uint8_t status)
+{
+    server_unsupported = true;
+    request_pending = false;
+    esp_zb_scheduler_alarm_cancel(esp_zb_orp_time_sync_request, 0);
+    ESP_LOGW(TAG, "Coordinator has no usable Time cluster (status 0x%x), readings stay unstamped until the next join",
+             status);
+}
+
+static int64_t esp_zb_orp_time_utc_us(int64_t mono_us)
+{
+    int64_t elapsed_us = mono_us - ref_mono_us;
+    return ref_utc_us + elapsed_us + elapsed_us * drift_ppb / 1000000000;
+}
+
+static void esp_zb_orp_time_apply(int64_t response_mono_us, uint32_t utc_s)
+{
+    /* The server read its clock somewhere within the round trip, and UTCTime truncates to seconds */
+    int64_t rtt_us = response_mono_us - request_mono_us;
+    int64_t mono_us = request_mono_us + rtt_us / 2;
+    int64_t utc_us = (int64_t)utc_s * 1000000 + 500000;
+    int64_t error_us = 500000 + rtt_us / 2;
+
+    if (synced) {
+        ESP_LOGI(TAG, "Local clock was off by %lld ms", (esp_zb_orp_time_utc_us(mono_us) - utc_us) / 1000);
+    }
+
+    if (anchor_valid && mono_us - anchor_mono_us >= (int64_t)ESP_ORP_TIME_DRIFT_MIN_SPAN_S * 1000000) {
+        int64_t mono_span_us = mono_us - anchor_mono_us;
+        int64_t offset_us = utc_us - anchor_utc_us - mono_span_us;
+        if (llabs(offset_us) > mono_span_us / 1000000 * ESP_ORP_TIME_UNKNOWN_DRIFT_PPM * 5) {
+            /* Far beyond any crystal or RC error: the coordinator clock was set, start over */
+            ESP_LOGW(TAG, "Coordinator time jumped, discarding drift estimate");
+            drift_known = false;
+            drift_ppb = 0;
+        } else {
+            int64_t measured_ppb = offset_us * 1000000000 / mono_span_us;
+            drift_ppb = drift_known ? drift_ppb + (int32_t)((measured_ppb - drift_ppb) / 4) : (int32_t)measured_ppb;
+            drift_known = true;
+        }
+        anchor_mono_us = mono_us;
+        anchor_utc_us = utc_us;
+    } else if (!anchor_valid) {
+        anchor_mono_us = mono_us;
+        anchor_utc_us = utc_us;
+        anchor_valid = true;
+    }
+
+    ref_mono_us = mono_us;
+    ref_utc_us = utc_us;
+    synced = true;
+    retry_s = ESP_ORP_TIME_SYNC_RETRY_S;
+
+    /* Error grows by one microsecond per second for every ppm of unknown drift */
+    uint32_t uncertainty_ppm = drift_known ? ESP_ORP_TIME_RESIDUAL_DRIFT_PPM : ESP_ORP_TIME_UNKNOWN_DRIFT_PPM;
+    int64_t budget_us = (int64_t)ESP_ORP_TIME_MAX_ERROR_MS * 1000 - error_us;
+    uint32_t next_sync_s = budget_us > 0 ? (uint32_t)(budget_us / uncertainty_ppm) : 0;
+    next_sync_s = MIN(MAX(next_sync_s, ESP_ORP_TIME_SYNC_MIN_INTERVAL_S), ESP_ORP_TIME_SYNC_MAX_INTERVAL_S);
+
+    esp_zb_scheduler_alarm_cancel(esp_zb_orp_time_sync_request, 0);
+    esp_zb_scheduler_alarm(esp_zb_orp_time_sync_request, 0, next_sync_s * 1000);
+    ESP_LOGI(TAG, "Time synced: UTC %lu, error %lld ms, drift %ld ppb%s, next sync in %lu s",
+             utc_s, error_us / 1000, drift_ppb, drift_known ? "" : " (not measured yet)", next_sync_s);
+}
+
+void esp_zb_orp_time_sync_start(void)
+{
+    /* A new network may have a different coordinator, give it a chance */
+    server_unsupported = false;
+    retry_s = ESP_ORP_TIME_SYNC_RETRY_S;
+    esp_zb_orp_time_sync_request(0);
+}
+
+void esp_zb_orp_time_sync_stop(void)
+{
+    esp_zb_scheduler_alarm_cancel(esp_zb_orp_time_sync_request, 0);
+    request_pending = false;
+}
+
+bool esp_zb_orp_time_read_resp_handler(const esp_zb_zcl_cmd_read_attr_resp_message_t *message)
+{
+    if (message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_TIME) {
+        return false;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_IDLE);
+    for (esp_zb_zcl_read_attr_resp_variable_t *variable = message->variables; variable; variable = variable->next) {
+        if (variable->status == ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB && variable->attribute.id == ESP_ZB_ZCL_ATTR_TIME_TIME_ID) {
+            esp_zb_orp_time_server_unsupported(variable->status);
+            continue;
+        }
+        if (variable->status != ESP_ZB_ZCL_STATUS_SUCCESS || variable->attribute.id != ESP_ZB_ZCL_ATTR_TIME_TIME_ID ||
+            !variable->attribute.data.value) {
+            continue;
+        }
+        uint32_t utc_s = *(uint32_t *)variable->attribute.data.value;
+        if (!request_pending || utc_s == ESP_ORP_TIME_INVALID) {
+            ESP_LOGW(TAG, "Ignoring %s time response", request_pending ? "invalid" : "unsolicited");
+            continue;
+        }
+        request_pending = false;
+        esp_zb_orp_time_apply(now_us, utc_s);
+    }
+    return true;
+}
+
+bool esp_zb_orp_time_default_resp_handler(const esp_zb_zcl_cmd_default_resp_message_t *message)
+{
+    if (message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_TIME) {
+        return false;
+    }
+
+    orp_sensor_radio_state_notify(ORP_SENSOR_RADIO_IDLE);
+    switch (message->status_code) {
+    case ESP_ZB_ZCL_STATUS_UNSUP_CLUST:
+    case ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB:
+    case ESP_ZB_ZCL_STATUS_UNSUP_GEN_CMD:
+        esp_zb_orp_time_server_unsupported(message->status_code);
+        break;
+    default:
+        ESP_LOGW(TAG, "Time read answered with status 0x%x, will retry", message->status_code);
+        break;
+    }
+    return true;
+}
+
+uint32_t esp_zb_orp_time_to_utc(int64_t mono_us)
+{
+    if (!synced) {
+        return ESP_ORP_TIME_INVALID;
+    }
+    return (uint32_t)(esp_zb_orp_time_utc_us(mono_us) / 1000000);
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee HA_orp_sensor Example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_zigbee_core.h"
+
+#define ESP_ORP_TIME_SERVER_ADDR            (0x0000)    /* Read the Time cluster from the coordinator */
+#define ESP_ORP_TIME_SERVER_ENDPOINT        (1)
+#define ESP_ORP_TIME_INVALID                (0xFFFFFFFF)    /* ZCL UTCTime "invalid" value */
+#define ESP_ORP_TIME_MAX_ERROR_MS           (2000)      /* Re-sync before the timestamp error can exceed this */
+#define ESP_ORP_TIME_UNKNOWN_DRIFT_PPM      (1000)      /* Assumed clock error until drift has been measured */
+#define ESP_ORP_TIME_RESIDUAL_DRIFT_PPM     (50)        /* Assumed clock error after drift compensation */
+#define ESP_ORP_TIME_DRIFT_MIN_SPAN_S       (6 * 60 * 60)   /* 1 s UTCTime resolution over 6 h is below 50 ppm */
+#define ESP_ORP_TIME_SYNC_MIN_INTERVAL_S    (5 * 60)
+#define ESP_ORP_TIME_SYNC_MAX_INTERVAL_S    (24 * 60 * 60)
+#define ESP_ORP_TIME_SYNC_RETRY_S           (5 * 60)    /* First retry of a sync that got no response, doubled up to the max interval */
+
+/**
+ * @brief Start synchronising with the coordinator Time cluster, call from the Zigbee task once joined
+ */
+void esp_zb_orp_time_sync_start(void);
+
+/**
+ * @brief Stop synchronising after the network was lost, call from the Zigbee task
+ *
+ * @note The current mapping is kept, so readings taken while offline still get timestamps
+ */
+void esp_zb_orp_time_sync_stop(void);
+
+/**
+ * @brief Handle a read attributes response, call from the Zigbee action handler
+ *
+ * @param message               read attributes response
+ *
+ * @return true if the response was a Time cluster response consumed by the time sync
+ */
+bool esp_zb_orp_time_read_resp_handler(const esp_zb_zcl_cmd_read_attr_resp_message_t *message);
+
+/**
+ * @brief Handle a default response, call from the Zigbee action handler
+ *
+ * @param message               default response
+ *
+ * @return true if the response was for the Time cluster
+ */
+bool esp_zb_orp_time_default_resp_handler(const esp_zb_zcl_cmd_default_resp_message_t *message);
+
+/**
+ * @brief Convert a monotonic esp_timer timestamp to ZCL UTCTime, call with the Zigbee lock held
+ *
+ * @param mono_us               esp_timer_get_time() value
+ *
+ * @return seconds since 2000-01-01 00:00 UTC, or ESP_ORP_TIME_INVALID before the first sync
+ */
+uint32_t esp_zb_orp_time_to_utc(int64_t mono_us);
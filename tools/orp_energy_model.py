@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: CC0-1.0
+"""Estimate the charge one ORP report costs and gate regressions against a baseline.
+
+The model integrates a current per device state (CPU active or idle, ADC,
+temperature sensor, 802.15.4 TX/RX, light sleep) over the timeline of one
+report period. The timeline is built from the configuration in the tree
+(main/esp_zb_orp_sensor.h and the driver Kconfig, or a build's sdkconfig), or
+taken from a device log recorded with CONFIG_ORP_SENSOR_ENERGY_TRACE.
+
+The configuration scenario only follows intervals and sample counts. How many
+frames the application sends per reading is a model assumption ('traffic'),
+so it does not notice code that adds or removes transmissions. Gate code
+changes with --trace; the configuration scenario gates configuration changes.
+A trace logs every ZCL frame once the stack confirms it, the poll intervals
+and the fast-poll windows, so parent polls are charged from the trace too.
+
+    python tools/orp_energy_model.py                       # configuration in the tree
+    python tools/orp_energy_model.py --trace monitor.log   # recorded timeline
+    python tools/orp_energy_model.py --check               # fail on >5% regression
+    python tools/orp_energy_model.py --update-baseline     # accept the current figure
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+APP_HEADER = os.path.join(ROOT, 'main', 'esp_zb_orp_sensor.h')
+DRIVER_KCONFIG = os.path.join(ROOT, 'components', 'orp_sensor_driver', 'Kconfig')
+BASELINE = os.path.join(ROOT, 'tools', 'energy_baseline.json')
+
+# Order-of-magnitude ESP32-C6 figures at 3.3 V. Replace them with bench measurements
+# of the actual board (--model FILE) before trusting absolute battery life numbers;
+# relative comparisons between configurations hold up better.
+DEFAULT_MODEL = {
+    'current_ma': {
+        'sleep': 0.18,          # light sleep, RTC timer and GPIO wakeup armed
+        'cpu_active': 30.0,     # CPU running at 160 MHz
+        'cpu_idle': 15.0,       # awake but waiting, e.g. between ADC samples
+        'adc': 1.5,             # added while a oneshot conversion runs
+        'temp_sensor': 0.15,    # added while the SoC temperature sensor is enabled
+        'radio_tx': 75.0,       # 802.15.4 transmit at 0 dBm
+        'radio_rx': 75.0,       # 802.15.4 receive, waiting for ACK or polled data
+    },
+    'timing_us': {
+        'wakeup': 1500,         # light-sleep exit and entry
+        'adc_conversion': 40,   # one calibrated oneshot conversion
+        'sample_gap': 10000,    # delay between samples in orp_sensor_read_raw()
+        'processing': 3000,     # sensor callback and ZCL attribute updates
+        'tx_frame': 2000,       # CSMA-CA and one attribute report on air
+        'ack_rx': 900,          # waiting for the MAC ACK
+        'poll_tx': 600,         # Data Request to the parent
+        'poll_rx': 3000,        # receive window after a poll
+    },
+    # Frames the application sends, assumed by the configuration scenario only
+    'traffic': {
+        'frames_per_reading': 1,        # ORP log Reading command, or present_value before the first time sync;
+                                        # automatic present_value reporting is disabled
+        'extra_frames_per_hour': 2,     # temperature, probe fault, offline backlog and Time cluster frames
+    },
+    'battery_mah': 2600,        # two AA cells
+}
+
+
+def parse_header(path):
+    """Integer #defines of the application header, arithmetic expressions allowed."""
+    defines = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'#define\s+(\w+)\s+(\([\d\s*+\-/()]+\))', line.split('/*')[0])
+            if m:
+                defines[m.group(1)] = eval(m.group(2), {'__builtins__': {}})
+    return defines
+
+
+def parse_kconfig(path):
+    """Defaults of the driver Kconfig, with single-symbol `if` conditions resolved."""
+    defaults = {}
+    name = None
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'\s*config\s+(\w+)', line)
+            if m:
+                name = m.group(1)
+                defaults[name] = []
+                continue
+            m = re.match(r'\s*default\s+(\S+)(?:\s+if\s+(!?\w+))?', line)
+            if m and name:
+                defaults[name].append((m.group(1), m.group(2)))
+
+    def value(symbol):
+        for val, cond in defaults.get(symbol, []):
+            if cond is None or (value(cond[1:]) == 'n' if cond.startswith('!') else value(cond) == 'y'):
+                return val
+        return 'n'
+
+    return {symbol: value(symbol) for symbol in defaults}
+
+
+def parse_sdkconfig(path):
+    config = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'CONFIG_(\w+)=(.*)', line.strip())
+            if m:
+                config[m.group(1)] = m.group(2).strip('"')
+            m = re.match(r'# CONFIG_(\w+) is not set', line.strip())
+            if m:
+                config[m.group(1)] = 'n'
+    return config
+
+
+def tree_config(sdkconfig, model):
+    app = parse_header(APP_HEADER)
+    driver = parse_kconfig(DRIVER_KCONFIG)
+    if sdkconfig:
+        driver.update(parse_sdkconfig(sdkconfig))
+    return {
+        'update_interval_s': app['ESP_ORP_SENSOR_UPDATE_INTERVAL'],
+        'long_poll_s': app['ESP_ORP_LONG_POLL_INTERVAL_QS'] / 4,
+        'check_in_s': app['ESP_ORP_CHECK_IN_INTERVAL_QS'] / 4,
+        'short_poll_s': app['ESP_ORP_SHORT_POLL_INTERVAL_QS'] / 4,
+        'fast_poll_timeout_s': app['ESP_ORP_FAST_POLL_TIMEOUT_QS'] / 4,
+        'samples': int(driver['ORP_SENSOR_SAMPLE_COUNT']),
+        'temp_compensation': driver.get('ORP_SENSOR_TEMP_COMPENSATION') == 'y',
+        'frames_per_reading': model['traffic']['frames_per_reading'],
+        'extra_frames_per_hour': model['traffic']['extra_frames_per_hour'],
+    }
+
+
+def config_timeline(cfg, model):
+    """(state list, duration us) spans of one report period, derived from the configuration."""
+    t = model['timing_us']
+    period_us = cfg['update_interval_s'] * 1e6
+    burst = ['temp_sensor'] if cfg['temp_compensation'] else []
+    spans = [
+        (['cpu_active'], t['wakeup']),
+        (['cpu_active', 'adc'] + burst, cfg['samples'] * t['adc_conversion']),
+        (['cpu_idle'] + burst, (cfg['samples'] - 1) * t['sample_gap']),
+        (['cpu_active'], t['processing']),
+    ]
+    frames = cfg['frames_per_reading'] + cfg['extra_frames_per_hour'] * cfg['update_interval_s'] / 3600
+    spans += [(['cpu_active', 'radio_tx'], frames * t['tx_frame']), (['cpu_active', 'radio_rx'], frames * t['ack_rx'])]
+
+    # Parent polls and check-in fast-poll windows, shared out over the reports in between
+    polls = period_us / (cfg['long_poll_s'] * 1e6)
+    check_ins = period_us / (cfg['check_in_s'] * 1e6)
+    polls += check_ins * cfg['fast_poll_timeout_s'] / cfg['short_poll_s']
+    spans += [(['cpu_active'], polls * t['wakeup']),
+              (['cpu_active', 'radio_tx'], (polls + check_ins) * t['poll_tx']),
+              (['cpu_active', 'radio_rx'], (polls + check_ins) * t['poll_rx'])]
+
+    awake_us = sum(duration for _, duration in spans)
+    spans.append((['sleep'], period_us - awake_us))
+    return spans
+
+
+def trace_timelines(path, model, cfg):
+    """Split an ORP_ENERGY device trace into report periods, one per acquisition burst."""
+    t = model['timing_us']
+    events = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = re.search(r'ORP_ENERGY (\d+) (\w+)((?: \S+)*)', line)
+            if m:
+                events.append((int(m.group(1)) * 1000, m.group(2), m.group(3).split()))
+    events.sort(key=lambda event: event[0])
+
+    # Poll intervals in effect over time, starting from the configuration for traces that begin
+    # after the join, and the fast-poll windows as (open, close) pairs
+    long_poll = [(0, cfg['long_poll_s'] * 1e6)]
+    short_poll = [(0, cfg['short_poll_s'] * 1e6)]
+    windows = []
+    for time_us, kind, args in events:
+        if kind == 'longpoll':
+            long_poll.append((time_us, int(args[0]) * 1000))
+        elif kind == 'shortpoll':
+            short_poll.append((time_us, int(args[0]) * 1000))
+        elif kind == 'fastpoll' and args[0] == '1':
+            windows.append([time_us, None])
+        elif kind == 'fastpoll' and windows and windows[-1][1] is None:
+            windows[-1][1] = time_us
+
+    def in_effect(changes, time_us):
+        return [value for changed_us, value in changes if changed_us <= time_us][-1]
+
+    starts = [time_us for time_us, kind, _ in events if kind == 'adc']
+    periods = []
+    for start, end in zip(starts, starts[1:]):
+        spans = []
+        for time_us, kind, args in events:
+            if not start <= time_us < end:
+                continue
+            if kind == 'adc':
+                # Duration, sample count and whether the temperature sensor was powered; traces
+                # recorded before the last field existed always powered it
+                converting_us = int(args[1]) * t['adc_conversion']
+                burst = ['temp_sensor'] if len(args) < 3 or args[2] != '0' else []
+                spans += [(['cpu_active', 'adc'] + burst, converting_us),
+                          (['cpu_idle'] + burst, int(args[0]) - converting_us)]
+            elif kind == 'tx':
+                spans += [(['cpu_active', 'radio_tx'], t['tx_frame']), (['cpu_active', 'radio_rx'], t['ack_rx'])]
+            elif kind == 'sleep':
+                spans.append((['sleep'], int(args[0])))
+        # Parent polls at the short interval inside fast-poll windows and at the long one outside
+        fast_us = sum(max(0, min(end, close or end) - max(start, opened)) for opened, close in windows)
+        polls = fast_us / in_effect(short_poll, start) + (end - start - fast_us) / in_effect(long_poll, start)
+        spans += [(['cpu_active', 'radio_tx'], polls * t['poll_tx']), (['cpu_active', 'radio_rx'], polls * t['poll_rx'])]
+        # Whatever was neither sleep nor a modelled span kept the CPU awake
+        spans.append((['cpu_idle'], max(0, end - start - sum(duration for _, duration in spans))))
+        periods.append(spans)
+    if not periods:
+        sys.exit(f'error: {path} holds fewer than two ORP_ENERGY acquisition bursts')
+    return periods
+
+
+def charge_uah(spans, model):
+    current = model['current_ma']
+    return sum(sum(current[state] for state in states) * duration for states, duration in spans) / 3.6e6
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--sdkconfig', help='sdkconfig of a build, overrides the Kconfig defaults')
+    parser.add_argument('--trace', help='device log recorded with CONFIG_ORP_SENSOR_ENERGY_TRACE')
+    parser.add_argument('--model', help='JSON file overriding entries of the current/timing model')
+    parser.add_argument('--scenario', help='baseline entry to use, defaults to "trace" or "config"')
+    parser.add_argument('--baseline', default=BASELINE, help='baseline file for --check and --update-baseline')
+    parser.add_argument('--threshold', type=float, default=5.0, help='allowed regression in percent')
+    parser.add_argument('--check', action='store_true', help='exit with 1 if the figure regressed')
+    parser.add_argument('--update-baseline', action='store_true', help='store the current figure as baseline')
+    args = parser.parse_args()
+
+    model = json.loads(json.dumps(DEFAULT_MODEL))
+    if args.model:
+        with open(args.model) as f:
+            for key, value in json.load(f).items():
+                if isinstance(value, dict):
+                    model[key].update(value)
+                else:
+                    model[key] = value
+
+    if args.trace:
+        periods = trace_timelines(args.trace, model, tree_config(args.sdkconfig, model))
+        per_report = [charge_uah(spans, model) for spans in periods]
+        uah = sum(per_report) / len(per_report)
+        period_s = sum(sum(d for _, d in spans) for spans in periods) / len(periods) / 1e6
+        print(f'{len(periods)} recorded report periods, {min(per_report):.2f}-{max(per_report):.2f} uAh each')
+    else:
+        cfg = tree_config(args.sdkconfig, model)
+        spans = config_timeline(cfg, model)
+        uah = charge_uah(spans, model)
+        period_s = cfg['update_interval_s']
+        print(', '.join(f'{key}={value}' for key, value in cfg.items()))
+        print('note: frames per reading are model assumptions, use --trace to cover code changes')
+
+    scenario = args.scenario or ('trace' if args.trace else 'config')
+    average_ma = uah * 3600 / period_s / 1000
+    life_days = model['battery_mah'] / average_ma / 24
+    print(f'{uah:.2f} uAh per report, {average_ma * 1000:.1f} uA average, '
+          f'{life_days:.0f} days on {model["battery_mah"]} mAh')
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    if args.update_baseline:
+        baseline[scenario] = round(uah, 3)
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=4, sort_keys=True)
+            f.write('\n')
+        print(f'baseline for {scenario} set to {uah:.3f} uAh')
+    elif args.check:
+        if scenario not in baseline:
+            sys.exit(f'error: no {scenario} baseline in {args.baseline}, run with --update-baseline')
+        change = (uah / baseline[scenario] - 1) * 100
+        print(f'{change:+.1f}% against the {baseline[scenario]:.3f} uAh baseline (limit +{args.threshold:.1f}%)')
+        if change > args.threshold:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
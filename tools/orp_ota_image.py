@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: CC0-1.0
+"""Build a Zigbee OTA file for the ORP sensor.
+
+With --base, the file carries a heatshrink-compressed detools patch from the
+firmware the device runs now (tag 0xF000, prefixed by the SHA-256 of the base
+image), otherwise the full image (tag 0x0000). The patch is applied back onto
+the base before the file is written and must reproduce the new image bit for
+bit.
+
+    pip install detools
+    python tools/orp_ota_image.py build/esp_zb_orp_sensor.bin \\
+        --base old/esp_zb_orp_sensor.bin --file-version 0x01000001 -o orp.ota
+"""
+
+import argparse
+import hashlib
+import io
+import struct
+import sys
+
+OTA_MAGIC = 0x0BEEF11E
+OTA_HEADER_VERSION = 0x0100
+OTA_HEADER_LENGTH = 56
+OTA_STACK_VERSION_PRO = 0x0002
+
+TAG_UPGRADE_IMAGE = 0x0000
+TAG_DELTA_PATCH = 0xF000
+
+ESP_IMAGE_HEADER_LEN = 24
+ESP_IMAGE_HASH_APPENDED_OFFSET = 23
+DIGEST_LEN = 32
+
+
+def base_digest(base):
+    """Digest esp_partition_get_sha256() returns for the running app."""
+    if len(base) > ESP_IMAGE_HEADER_LEN and base[ESP_IMAGE_HASH_APPENDED_OFFSET] == 1:
+        return base[-DIGEST_LEN:]
+    return hashlib.sha256(base).digest()
+
+
+def create_delta(base, image):
+    try:
+        import detools
+    except ImportError:
+        sys.exit('error: delta images need detools, run `pip install detools`')
+
+    patch = io.BytesIO()
+    detools.create_patch(io.BytesIO(base), io.BytesIO(image), patch, compression='heatshrink')
+    patch = patch.getvalue()
+
+    merged = io.BytesIO()
+    detools.apply_patch(io.BytesIO(base), io.BytesIO(patch), merged)
+    if merged.getvalue() != image:
+        sys.exit('error: patch does not reproduce the new image')
+    return patch
+
+
+def ota_file(args, tag, payload):
+    element = struct.pack('<HI', tag, len(payload)) + payload
+    header_string = args.header_string.encode()[:32].ljust(32, b'\0')
+    header = struct.pack('<IHHHHHIH32sI', OTA_MAGIC, OTA_HEADER_VERSION, OTA_HEADER_LENGTH, 0,
+                         args.manufacturer, args.image_type, args.file_version, OTA_STACK_VERSION_PRO,
+                         header_string, OTA_HEADER_LENGTH + len(element))
+    return header + element
+
+
+def blocks(size, block_size):
+    return (size + block_size - 1) // block_size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('image', help='new application image (.bin)')
+    parser.add_argument('--base', help='application image the devices run now, builds a delta patch')
+    parser.add_argument('-o', '--output', required=True, help='OTA file to write')
+    parser.add_argument('--file-version', type=lambda x: int(x, 0), required=True)
+    parser.add_argument('--manufacturer', type=lambda x: int(x, 0), default=0x1001)
+    parser.add_argument('--image-type', type=lambda x: int(x, 0), default=0x1011)
+    parser.add_argument('--header-string', default='ORP sensor')
+    parser.add_argument('--block-size', type=int, default=223, help='OTA block payload size')
+    args = parser.parse_args()
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+
+    if args.base:
+        with open(args.base, 'rb') as f:
+            base = f.read()
+        data = ota_file(args, TAG_DELTA_PATCH, base_digest(base) + create_delta(base, image))
+    else:
+        data = ota_file(args, TAG_UPGRADE_IMAGE, image)
+
+    with open(args.output, 'wb') as f:
+        f.write(data)
+
+    full_size = len(ota_file(args, TAG_UPGRADE_IMAGE, image))
+    print(f'{args.output}: {len(data)} bytes, {blocks(len(data), args.block_size)} blocks '
+          f'(full image {full_size} bytes, {blocks(full_size, args.block_size)} blocks)')
+
+
+if __name__ == '__main__':
+    main()
@@ -1,11 +1,83 @@
+import {Zcl} from 'zigbee-herdsman';
+import * as exposes from 'zigbee-herdsman-converters/lib/exposes';
 import * as m from 'zigbee-herdsman-converters/lib/modernExtend';
 
+const ORP_ENDPOINT = 10;
+const ORP_LOG_RECORD_SIZE = 7;
+
+// Probe fault codes, the Analog Input reliability values the firmware uses
+const PROBE_FAULTS = {
+    none: 0,
+    over_range: 2,
+    under_range: 3,
+    stuck: 6,
+    noisy: 7,
+    step: 8,
+    drift: 10,
+};
+
+// ORP log records: UTCTime (uint32, seconds since 2000-01-01), ORP in mV (int16), probe fault (uint8)
+function orpLogRecords(data) {
+    const records = [];
+    for (let i = 0; i + ORP_LOG_RECORD_SIZE <= data.length; i += ORP_LOG_RECORD_SIZE) {
+        records.push({
+            sample_time: data.readUInt32LE(i),
+            orp: data.readInt16LE(i + 4),
+            fault: data.readUInt8(i + 6),
+        });
+    }
+    return records;
+}
+
+const orpLog = {
+    isModernExtend: true,
+    fromZigbee: [{
+        cluster: 'orpLog',
+        type: ['commandReading', 'commandBacklog'],
+        convert: (model, msg, publish, options, meta) => {
+            const records = orpLogRecords(msg.data.records);
+            if (msg.type === 'commandBacklog') {
+                // Readings averaged while the sensor was offline, oldest first; kept out of the live orp value
+                return records.length ? {orp_backlog: records} : undefined;
+            }
+            const record = records.pop();
+            if (!record) {
+                return undefined;
+            }
+            const probeFault = Object.keys(PROBE_FAULTS).find((name) => PROBE_FAULTS[name] === record.fault);
+            return {orp: record.orp, sample_time: record.sample_time, probe_fault: probeFault};
+        },
+    }],
+    exposes: [
+        exposes.numeric('sample_time', exposes.access.STATE)
+            .withUnit('s')
+            .withDescription('UTC time the ORP reading was sampled, seconds since 2000-01-01'),
+    ],
+    configure: [
+        async (device, coordinatorEndpoint) => {
+            await device.getEndpoint(ORP_ENDPOINT).bind('orpLog', coordinatorEndpoint);
+        },
+    ],
+};
+
 export default {
     zigbeeModel: ['esp32c6'],
     model: 'esp32c6',
     vendor: 'ESPRESSIF',
     description: 'ESP32-C6 ORP Sensor',
     extend: [
+        m.deviceAddCustomCluster('orpLog', {
+            ID: 0xfc01,
+            attributes: {
+                formatVersion: {ID: 0x0000, type: Zcl.DataType.UINT8},
+            },
+            commands: {},
+            commandsResponse: {
+                reading: {ID: 0x00, parameters: [{name: 'records', type: Zcl.DataType.OCTET_STR}]},
+                backlog: {ID: 0x01, parameters: [{name: 'records', type: Zcl.DataType.OCTET_STR}]},
+            },
+        }),
+        orpLog,
         m.numeric({
             name: "orp",
             cluster: "genAnalogInput",
@@ -14,11 +86,8 @@ export default {
             unit: "mV",
             precision: 1,
             access: "STATE_GET",
-            reporting: {
-                min: 1,        
-                max: 10,       
-                change: 1    
-            },
+            // Readings arrive as timestamped orpLog frames, reporting would overwrite them with arrival-stamped values
+            reporting: null,
         }),
         m.numeric({
             name: "orp_calibration",
@@ -31,6 +100,19 @@ export default {
             valueMin: -500,
             valueMax: 500,
             reporting: null,
+        }),
+        m.enumLookup({
+            name: "probe_fault",
+            cluster: "genAnalogInput",
+            attribute: "reliability",
+            description: "ORP probe health",
+            lookup: PROBE_FAULTS,
+            access: "STATE_GET",
+            reporting: null,
+        }),
+        m.temperature({
+            description: "SoC temperature the ORP reading is compensated with",
+            reporting: null,
         })
     ],
     meta: {},